@@ -0,0 +1,29 @@
+#!/bin/sh
+# Runs every example with and without the native tier and checks the output matches.
+# The tier is built with a threshold of 1 so every function gets compiled on its first call, at least one of them has to make it.
+set -e
+cd "$(dirname "$0")/.."
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+${CC:-cc} -std=c11 -O2 -DLX_BUILD_CLI lx.c -o "$out/lx"
+${CC:-cc} -std=c11 -O2 -DLX_BUILD_CLI -DLX_BUILD_JIT -DLX_JIT_THRESHOLD=1 lx.c -o "$out/lx-jit"
+
+compiled=0
+for example in examples/*.lx; do
+    "$out/lx" "$example" < /dev/null > "$out/interpreted"
+    "$out/lx-jit" -jit "$example" < /dev/null > "$out/native" 2> "$out/count"
+    if ! cmp -s "$out/interpreted" "$out/native"; then
+        echo "$example: output differs with -jit"
+        diff "$out/interpreted" "$out/native" || true
+        exit 1
+    fi
+    count=$(sed -n 's/^\([0-9]*\) functions compiled natively.*/\1/p' "$out/count")
+    echo "$example: ok, ${count:-0} compiled"
+    compiled=$((compiled + ${count:-0}))
+done
+
+if [ "$compiled" -eq 0 ]; then
+    echo "no function was compiled natively"
+    exit 1
+fi
@@ -51,17 +51,23 @@ static double lx_parsenumber(const char* str, const char** end) {
     return val;
 }
 
-enum lx_Type { LX_FREE, LX_NIL, LX_NUMBER, LX_STRING, LX_SYMBOL, LX_LIST, LX_ENV, LX_FN, LX_CFN, LX_CALL, LX_EOF };
-static const char* formats[] = { "<free>", "<nil>", "<number>", "<string>", "<symbol>", "<list>", "<env>", "<fn>", "<cfn>", "<call>", "<eof>" };
+enum lx_Type { LX_FREE, LX_NIL, LX_NUMBER, LX_INT, LX_STRING, LX_SYMBOL, LX_LIST, LX_ENV, LX_FN, LX_CFN, LX_CALL, LX_RANGE, LX_BUFFER, LX_EOF };
+static const char* formats[] = { "<free>", "<nil>", "<number>", "<int>", "<string>", "<symbol>", "<list>", "<env>", "<fn>", "<cfn>", "<call>", "<range>", "<buffer>", "<eof>" };
 
 struct lx_Value {
     unsigned char mark : 1;
     unsigned char persist : 1;
-    unsigned char type : 6;
+    unsigned char transient : 1;
+    unsigned char root : 1;
+    unsigned char type : 4;
+
+    // Only used while compacting, the 1-based cell index this cell moves to
+    unsigned int forward;
     
     union {
         lx_Value* free;
         double number;
+        long long integer;
         struct {
             const char* start;
             int len;
@@ -74,6 +80,7 @@ struct lx_Value {
         struct {
             const char* arg_start;
             const char* body_start;
+            int jit; // 1-based entry in the native tier's table, 0 until the tier has seen the function
         } fn;
         struct {
             const char* args;
@@ -84,13 +91,61 @@ struct lx_Value {
             lx_Value* callable;
             lx_Value* last;
         } call;
+        struct {
+            double start;
+            double end;
+            double step;
+        } range;
+        struct {
+            void* data;
+            int len;
+            unsigned char bytes;
+            unsigned char writable;
+        } buffer;
     };
 };
 
 static lx_Value lx_nil_ = { .type = LX_NIL };
 static lx_Value lx_eof = { .type = LX_EOF };
-static lx_Value lx_zero = { .type = LX_NUMBER, .number = 0 };
-static lx_Value lx_one = { .type = LX_NUMBER, .number = 1 };
+static lx_Value lx_zero = { .type = LX_INT, .integer = 0 };
+static lx_Value lx_one = { .type = LX_INT, .integer = 1 };
+
+// Literals without a decimal point are integers, unless they don't fit in 64 bits
+static lx_Value lx_parseliteral(const char* str, const char** end) {
+    const char* digit = str;
+    long long val = 0;
+    for (; lx_isdigit(*digit); digit++) {
+        if (val > (0x7fffffffffffffffLL - (*digit - '0')) / 10) break;
+        val = val * 10 + (*digit - '0');
+    }
+
+    if (lx_isdigit(*digit) || *digit == '.') return (lx_Value) { .type = LX_NUMBER, .number = lx_parsenumber(str, end) };
+    if (end) *end = digit;
+    return (lx_Value) { .type = LX_INT, .integer = val };
+}
+
+// Doubles outside the 64-bit range clamp to its ends, nan becomes 0
+static long long lx_toint(double n) {
+    if (n != n) return 0;
+    if (n >= 9223372036854775807.0) return 0x7fffffffffffffffLL;
+    if (n <= -9223372036854775808.0) return -0x7fffffffffffffffLL - 1;
+    return (long long)n;
+}
+
+static int lx_whole(double n) { return n > -9223372036854775808.0 && n < 9223372036854775807.0 && n == (double)(long long)n; }
+
+// A block of cells - the first one lives in the context's arena, any others come from the host allocator
+typedef struct lx_Segment lx_Segment;
+struct lx_Segment {
+    lx_Segment* next;
+    lx_Value* start;
+    lx_Value* end;
+    int live;
+    int base;
+};
+
+// Visits every cell in every segment, in order
+#define FOR_CELLS(seg, val) for (lx_Segment* seg = &ctx->cells; seg; seg = seg->next) for (lx_Value* val = seg->start; val < seg->end; val++)
 
 struct lx_Ctx {
     lx_Printer printer;
@@ -98,17 +153,41 @@ struct lx_Ctx {
     char* prog_start;
     char* prog_end;
     
-    lx_Value* cell_start;
-    lx_Value* cell_end;
+    lx_Segment cells;
+    lx_Allocator allocator;
+    void* allocator_data;
 
     lx_Value* free_list;
     lx_Value* current;
 
+    lx_Value* frame_start;
+    lx_Value* frame_top;
+    lx_Value* frame_end;
+    lx_Value** temps;
+    int temp_top;
+    int temp_cap;
+
+    lx_Value* handles[LX_HANDLES];
+    int collections;
+    int compact_every;
+    int compacted_at;
+
+#ifdef LX_BUILD_JIT
+    void* jit;
+#endif
+
     char format_buffer[LX_FORMAT_LEN];
 };
 
+static int lx_grow(lx_Ctx* ctx);
+
 static lx_Value* lx_alloc(lx_Ctx* ctx, unsigned char type, unsigned char mark) {
-    if (ctx->free_list == 0) if (!lx_gc(ctx)) { return 0; }
+    // Grow when a collection wins back too little of the heap
+    if (ctx->free_list == 0) {
+        int n_freed = lx_gc(ctx);
+        if (n_freed * 100LL < lx_cells(ctx) * (long long)LX_GROW_PERCENT) lx_grow(ctx);
+        if (ctx->free_list == 0) { return 0; }
+    }
     
     lx_Value* item = ctx->free_list;
     item->type = type; item->mark = mark;
@@ -123,12 +202,24 @@ static lx_Value* lx_promote(lx_Ctx* ctx, lx_Value val) {
     return new_val;
 }
 
+// Transient cells are updated in place (like loop counters), so they're copied whenever something holds on to them
+static lx_Value* lx_stash(lx_Ctx* ctx, lx_Value* val) {
+    if (!val || !val->transient) return val;
+    val = lx_promote(ctx, *val);
+    val->transient = 0; val->mark = 1;
+    return val;
+}
+
 lx_Value* lx_nil(void) { return &lx_nil_; }
 int ix_isnil(lx_Value* val) { return val->type == LX_NIL; }
 
 lx_Value* lx_number(lx_Ctx* ctx, double number) { return lx_promote(ctx, (lx_Value) { .type = LX_NUMBER, .number = number }); }
-int lx_isnumber(lx_Value* val) { return val->type == LX_NUMBER; }
-double lx_getnumber(lx_Value* val) { return lx_isnumber(val) ? val->number : 0.0; }
+int lx_isnumber(lx_Value* val) { return val->type == LX_NUMBER || val->type == LX_INT; }
+double lx_getnumber(lx_Value* val) { return val->type == LX_INT ? (double)val->integer : val->type == LX_NUMBER ? val->number : 0.0; }
+
+lx_Value* lx_int(lx_Ctx* ctx, long long integer) { return lx_promote(ctx, (lx_Value) { .type = LX_INT, .integer = integer }); }
+int lx_isint(lx_Value* val) { return val->type == LX_INT; }
+long long lx_getint(lx_Value* val) { return val->type == LX_INT ? val->integer : val->type == LX_NUMBER ? lx_toint(val->number) : 0; }
 
 lx_Value* lx_string(lx_Ctx* ctx, const char* str) { return lx_promote(ctx, (lx_Value) { .type = LX_STRING, .string = { .start = str, .len = lx_strlen(str)  }}); }
 int lx_isstring(lx_Value* val) { return val->type == LX_STRING; }
@@ -145,6 +236,44 @@ int lx_isfn(lx_Value* val) { return val->type == LX_FN; }
 lx_Value* lx_cfn(lx_Ctx* ctx, const char* args, lx_Cfn cfn) { return lx_promote(ctx, (lx_Value) { .type = LX_CFN, .cfn = { .args = args, .cfn = cfn } }); }
 int lx_iscfn(lx_Value* val) { return val->type == LX_CFN; }
 
+lx_Value* lx_range(lx_Ctx* ctx, double start, double end, double step) { return lx_promote(ctx, (lx_Value) { .type = LX_RANGE, .range = { .start = start, .end = end, .step = step } }); }
+int lx_isrange(lx_Value* val) { return val->type == LX_RANGE; }
+
+int lx_rangelen(lx_Value* val) {
+    if (!lx_isrange(val) || val->range.step == 0) return 0;
+    double steps = (val->range.end - val->range.start) / val->range.step;
+    if (!(steps > 0)) return 0;
+    // Longer ranges can't be indexed or counted with an int anyway, so they stop at the largest one
+    if (steps >= 0x7fffffff) return 0x7fffffff;
+    int len = (int)steps;
+    return len < steps ? len + 1 : len;
+}
+
+// Ranges whose start and step are whole numbers count in integers, as long as the element fits in one.
+// The double estimate is close enough to tell, and once the result fits, wrapping unsigned arithmetic gets it exactly
+static lx_Value lx_rangeat(lx_Value* range, int i) {
+    double start = range->range.start, step = range->range.step, at = start + i * step;
+    if (lx_whole(start) && lx_whole(step) && at > -9e18 && at < 9e18) {
+        unsigned long long integer = (unsigned long long)(long long)start + (unsigned long long)i * (unsigned long long)(long long)step;
+        return (lx_Value) { .type = LX_INT, .integer = (long long)integer };
+    }
+    return (lx_Value) { .type = LX_NUMBER, .number = at };
+}
+
+lx_Value* lx_buffer(lx_Ctx* ctx, double* data, int len, int writable) { return lx_promote(ctx, (lx_Value) { .type = LX_BUFFER, .buffer = { .data = data, .len = len, .bytes = 0, .writable = writable } }); }
+lx_Value* lx_bytes(lx_Ctx* ctx, unsigned char* data, int len, int writable) { return lx_promote(ctx, (lx_Value) { .type = LX_BUFFER, .buffer = { .data = data, .len = len, .bytes = 1, .writable = writable } }); }
+int lx_isbuffer(lx_Value* val) { return val->type == LX_BUFFER; }
+
+static lx_Value lx_bufferget(lx_Value* buf, int i) {
+    if (buf->buffer.bytes) return (lx_Value) { .type = LX_INT, .integer = ((unsigned char*)buf->buffer.data)[i] };
+    return (lx_Value) { .type = LX_NUMBER, .number = ((double*)buf->buffer.data)[i] };
+}
+// Bytes saturate instead of wrapping around, so storing 300 gives 255 and anything negative gives 0
+static void lx_bufferset(lx_Value* buf, int i, double n) {
+    if (buf->buffer.bytes) ((unsigned char*)buf->buffer.data)[i] = (unsigned char)(n >= 255 ? 255 : n > 0 ? lx_toint(n) : 0);
+    else ((double*)buf->buffer.data)[i] = n;
+}
+
 lx_Value* lx_list(lx_Ctx* ctx) { return lx_promote(ctx, (lx_Value) { .type = LX_LIST, .list = { .value = 0, .next = 0 } }); }
 int lx_islist(lx_Value* val) { return val->type == LX_LIST; }
 lx_Value* lx_getlist(lx_Value* val) { return lx_islist(val) ? val->list.value : &lx_nil_; }
@@ -152,6 +281,7 @@ lx_Value* lx_listnext(lx_Value* val) { return lx_islist(val) ? val->list.next :
 
 lx_Value* lx_listappend(lx_Ctx* ctx, lx_Value* list, lx_Value* item) {
     if (!lx_islist(list)) return lx_nil();
+    item = lx_stash(ctx, item);
     if (!list->list.value) { list->list.value = item; return list; }
     while (list->list.next) list = list->list.next;
     list->list.next = lx_list(ctx);
@@ -159,6 +289,40 @@ lx_Value* lx_listappend(lx_Ctx* ctx, lx_Value* list, lx_Value* item) {
     return list->list.next;
 }
 
+static lx_Value* lx_marktemp(lx_Ctx* ctx, lx_Value* v);
+
+lx_Value* lx_listfromarray(lx_Ctx* ctx, lx_Value** items, int count) {
+    // Until they're appended nothing but `items` refers to the values, so they're all rooted for as long as building the list can collect
+    int temp_top = ctx->temp_top;
+    for (int i = 0; i < count; i++) lx_marktemp(ctx, items[i]);
+    lx_Value* list = lx_marktemp(ctx, lx_list(ctx)),* tail = list;
+    for (int i = 0; i < count; i++) tail = lx_listappend(ctx, tail, items[i]);
+    ctx->temp_top = temp_top;
+    return list;
+}
+
+lx_Value* lx_listfromnumbers(lx_Ctx* ctx, const double* numbers, int count) {
+    lx_Value* list = lx_list(ctx),* tail = list;
+    list->persist = 1;
+    for (int i = 0; i < count; i++) { tail = lx_listappend(ctx, tail, &lx_nil_); tail->list.value = lx_number(ctx, numbers[i]); }
+    list->persist = 0;
+    return list;
+}
+
+int lx_listtoarray(lx_Value* list, lx_Value** items, int max) {
+    int count = 0;
+    if (!lx_islist(list) || !list->list.value) return 0;
+    for (; list && count < max; list = list->list.next) items[count++] = list->list.value;
+    return count;
+}
+
+int lx_listtonumbers(lx_Value* list, double* numbers, int max) {
+    int count = 0;
+    if (!lx_islist(list) || !list->list.value) return 0;
+    for (; list && count < max; list = list->list.next) numbers[count++] = lx_getnumber(list->list.value);
+    return count;
+}
+
 lx_Value* lx_listpop(lx_Value* list) {
     if (!lx_islist(list)) return lx_nil();
     lx_Value* prev = list;
@@ -177,60 +341,156 @@ lx_Ctx* lx_open(void* memory, unsigned long long prog_size, unsigned long long c
     ctx->prog_start = ((char*)memory + sizeof(lx_Ctx));
     ctx->prog_end = ((char*)memory + prog_size);
 
-    ctx->cell_start = (lx_Value*)lx_align((long long)ctx->prog_end, sizeof(lx_Value));
-    ctx->cell_end = (lx_Value*)((char*)memory + prog_size + cell_size);
+    ctx->cells.start = (lx_Value*)lx_align((long long)ctx->prog_end, sizeof(lx_Value));
+    ctx->cells.end = ctx->cells.start + ((char*)memory + prog_size + cell_size - (char*)ctx->cells.start) / (long long)sizeof(lx_Value);
 
-    for (lx_Value* val = ctx->cell_start; val < ctx->cell_end - 1; val++) {
+    long long frame_cells = (ctx->cells.end - ctx->cells.start) / 4;
+    frame_cells = (frame_cells < LX_FRAME_CELLS ? frame_cells : LX_FRAME_CELLS) & -2;
+    ctx->frame_end = ctx->cells.end;
+    ctx->cells.end -= frame_cells;
+    ctx->frame_start = ctx->frame_top = ctx->cells.end;
+
+    long long temp_cells = (ctx->cells.end - ctx->cells.start) / 8, slots_per_cell = sizeof(lx_Value) / sizeof(lx_Value*);
+    temp_cells = temp_cells < LX_TEMP_SLOTS / slots_per_cell ? temp_cells : LX_TEMP_SLOTS / slots_per_cell;
+    ctx->cells.end -= temp_cells;
+    ctx->temps = (lx_Value**)ctx->cells.end;
+    ctx->temp_cap = (int)(temp_cells * slots_per_cell);
+
+    for (lx_Value* val = ctx->cells.start; val < ctx->cells.end - 1; val++) {
         val->type = LX_FREE;
         val->free = val + 1;
     }
 
-    ctx->free_list = ctx->cell_start;
-    (ctx->cell_start + ((ctx->cell_end - ctx->cell_start) - 1))->free = 0;
+    ctx->free_list = ctx->cells.start;
+    (ctx->cells.start + ((ctx->cells.end - ctx->cells.start) - 1))->free = 0;
 
     return ctx;
 }
 
-int lx_cells(lx_Ctx* ctx) { return (int)(ctx->cell_end - ctx->cell_start); }
+void lx_close(lx_Ctx* ctx) {
+    while (ctx->cells.next) {
+        lx_Segment* seg = ctx->cells.next;
+        ctx->cells.next = seg->next;
+        ctx->allocator(ctx->allocator_data, seg, 0);
+    }
+    if (ctx->temps != (lx_Value**)ctx->cells.end) ctx->allocator(ctx->allocator_data, ctx->temps, 0);
+#ifdef LX_BUILD_JIT
+    lx_jit(ctx, 0);
+#endif
+}
+
+void lx_setallocator(lx_Ctx* ctx, lx_Allocator allocator, void* userdata) {
+    ctx->allocator = allocator;
+    ctx->allocator_data = userdata;
+}
+
+int lx_cells(lx_Ctx* ctx) {
+    long long cells = 0;
+    for (lx_Segment* seg = &ctx->cells; seg; seg = seg->next) cells += seg->end - seg->start;
+    return (int)cells;
+}
+
+// Adds a segment through the host allocator, at least LX_SEGMENT_CELLS big and otherwise as big as the heap so far
+static int lx_grow(lx_Ctx* ctx) {
+    if (!ctx->allocator) return 0;
+
+    long long cells = lx_cells(ctx), header = lx_align(sizeof(lx_Segment), sizeof(lx_Value));
+    cells = cells > LX_SEGMENT_CELLS ? cells : LX_SEGMENT_CELLS;
+    lx_Segment* seg = (lx_Segment*)ctx->allocator(ctx->allocator_data, 0, header + cells * sizeof(lx_Value));
+    if (!seg) return 0;
+
+    seg->start = (lx_Value*)((char*)seg + header);
+    seg->end = seg->start + cells;
+    seg->next = 0;
+
+    lx_Segment* last = &ctx->cells;
+    while (last->next) last = last->next;
+    last->next = seg;
+
+    for (lx_Value* val = seg->start; val < seg->end; val++) *val = (lx_Value) { .type = LX_FREE, .free = val + 1 };
+    (seg->end - 1)->free = ctx->free_list;
+    ctx->free_list = seg->start;
+    return 1;
+}
+
+// Hands segments without a single live cell back to the host, as long as the rest of the heap stays at most half full.
+// Only compaction calls this, since it's what empties whole segments - after a plain collection live cells stay scattered across all of them
+static void lx_shrink(lx_Ctx* ctx) {
+    if (!ctx->allocator) return;
+
+    long long live = 0, cells = 0;
+    for (lx_Segment* seg = &ctx->cells; seg; seg = seg->next) { live += seg->live; cells += seg->end - seg->start; }
+
+    for (lx_Segment** link = &ctx->cells.next; *link;) {
+        lx_Segment* seg = *link;
+        long long size = seg->end - seg->start;
+        if (seg->live || live * 2 > cells - size) { link = &seg->next; continue; }
+
+        *link = seg->next;
+        cells -= size;
+        ctx->allocator(ctx->allocator_data, seg, 0);
+    }
+}
+
+static int lx_formatdigits(char* buffer, unsigned long long n) {
+    int len = 0;
+    do { buffer[len++] = '0' + (char)(n % 10); n /= 10; } while (n > 0);
+
+    for (int i = 0, j = len - 1; i < j; i++, j--) {
+        char c = buffer[i];
+        buffer[i] = buffer[j];
+        buffer[j] = c;
+    }
+    return len;
+}
 
 const char* lx_format(lx_Ctx* ctx, lx_Value* val) {
     switch (val->type) {
     case LX_NUMBER: {
-            int len = 0;
-            int int_part = (int)val->number;
-            int_part = int_part > 0 ? int_part : -int_part;    
-
+            int len = 0, exponent = 0;
+            double number = val->number < 0 ? -val->number : val->number;
             if (val->number < 0) { ctx->format_buffer[len++] = '-'; }
-
-            if (int_part == 0) ctx->format_buffer[len++] = '0';
-            while (int_part > 0) {
-                ctx->format_buffer[len++] = '0' + (int_part % 10);
-                int_part = int_part / 10;
+            if (number - number != 0) {
+                const char* word = number != number ? "nan" : "inf";
+                while (*word) ctx->format_buffer[len++] = *word++;
+                ctx->format_buffer[len] = 0;
+                return ctx->format_buffer;
             }
 
-            for (int i = val->number < 0, j = len - 1; i < j; i++, j--) {
-                char c = ctx->format_buffer[i];
-                ctx->format_buffer[i] = ctx->format_buffer[j];
-                ctx->format_buffer[j] = c;
-            }
+            // Anything past the 64-bit range is written as a mantissa and exponent instead
+            if (number >= 9223372036854775807.0) while (number >= 10) { number /= 10; exponent++; }
+            unsigned long long int_part = (unsigned long long)number;
+            len += lx_formatdigits(ctx->format_buffer + len, int_part);
 
-            double frac_part = val->number - (int)val->number;
-            frac_part = frac_part > 0 ? frac_part : -frac_part;    
+            double frac_part = number - (double)int_part;
             if (frac_part > 0.00001) {
                 ctx->format_buffer[len++] = '.';
 
                 int decimals = 0;
                 while (frac_part > 0 && (decimals++) < 6) {
                     frac_part *= 10;
-                    int_part = (int)frac_part;
-                    frac_part -= int_part;
-                    ctx->format_buffer[len++] = '0' + int_part;
+                    int digit = (int)frac_part;
+                    frac_part -= digit;
+                    ctx->format_buffer[len++] = '0' + digit;
                 }
             }
+
+            if (exponent) {
+                ctx->format_buffer[len++] = 'e';
+                len += lx_formatdigits(ctx->format_buffer + len, exponent);
+            }
             
             ctx->format_buffer[len] = 0;
             return ctx->format_buffer;
     }
+    case LX_INT: {
+            int len = 0;
+            unsigned long long magnitude = (unsigned long long)val->integer;
+            if (val->integer < 0) { ctx->format_buffer[len++] = '-'; magnitude = 0 - magnitude; }
+            len += lx_formatdigits(ctx->format_buffer + len, magnitude);
+            ctx->format_buffer[len] = 0;
+            return ctx->format_buffer;
+    }
     case LX_STRING: {
             int len = val->string.len > (LX_FORMAT_LEN - 1) ? (LX_FORMAT_LEN - 1) : val->string.len;
             for (int i = 0; i < len; ++i) ctx->format_buffer[i] = val->string.start[i];
@@ -241,36 +501,166 @@ const char* lx_format(lx_Ctx* ctx, lx_Value* val) {
     }
 }
 
+// Follows chains iteratively and stops at marked cells, so long lists don't exhaust the stack and nothing is walked twice
 static void mark(lx_Value* v) {
-    if (!v) return;
-
-    v->mark = 1u;
-    switch (v->type) {
-    case LX_LIST: mark(v->list.next); mark(v->list.value); break;
-    case LX_ENV: mark(v->env.next); mark(v->env.name); mark(v->env.value); break;
-    case LX_CALL: mark(v->call.callable); mark(v->call.env); mark(v->call.last); break;
+    while (v && !v->mark) {
+        v->mark = 1u;
+        switch (v->type) {
+        case LX_LIST: mark(v->list.value); v = v->list.next; break;
+        case LX_ENV: mark(v->env.name); mark(v->env.value); v = v->env.next; break;
+        case LX_CALL: mark(v->call.callable); mark(v->call.env); v = v->call.last; break;
+        default: return;
+        }
     }
 }
 
+// Calls and frames live outside cell memory, so the sweep never clears their marks
+static void lx_unmarkroots(lx_Ctx* ctx) {
+    for (lx_Value* call = ctx->current; call; call = call->call.last) call->mark = 0;
+    for (lx_Value* val = ctx->frame_start; val < ctx->frame_top; val++) val->mark = 0;
+}
+
 int lx_gc(lx_Ctx* ctx) {
+    // Cells marked ahead of a collection are temporary roots (see lx_marktemp), so whatever they reach has to survive as well
+    FOR_CELLS(seg, val) if (val->mark) { val->mark = 0; val->root = 1; }
+    lx_unmarkroots(ctx);
+
     mark(ctx->current);
 
-    for (lx_Value* val = ctx->cell_start; val < ctx->cell_end; val++) if (val->persist) mark(val);
+    FOR_CELLS(seg, val) if (val->persist || val->root) { val->root = 0; mark(val); }
+    // A frame only ever grows upwards from its head, so walking in address order marks each frame from its head and skips the links after it
+    for (lx_Value* val = ctx->frame_start; val < ctx->frame_top; val += 2) if (!val->mark) mark(val);
+    for (int i = 0; i < ctx->temp_top; i++) mark(ctx->temps[i]);
+    for (int i = 0; i < LX_HANDLES; i++) mark(ctx->handles[i]);
 
+    // Sweep in address order so the free list hands out cells in ascending order
     int n_freed = 0;
-    for (lx_Value* val = ctx->cell_start; val < ctx->cell_end; val++) {
+    lx_Value** tail = &ctx->free_list;
+    FOR_CELLS(seg, val) {
         if (val->mark) val->mark = 0;
         else {
             val->type = LX_FREE;
-            val->free = ctx->free_list;
-            ctx->free_list = val;
+            *tail = val;
+            tail = &val->free;
             n_freed++;
         }
     }
+    *tail = 0;
 
+    lx_unmarkroots(ctx);
+    ctx->collections++;
     return n_freed;
 }
 
+static lx_Segment* lx_segmentof(lx_Ctx* ctx, lx_Value* v) {
+    for (lx_Segment* seg = &ctx->cells; seg; seg = seg->next) if (v >= seg->start && v < seg->end) return seg;
+    return 0;
+}
+
+// Cells are numbered across segments while compacting, `base` being the number of the first cell in each
+static lx_Value* lx_cellat(lx_Ctx* ctx, unsigned int index) {
+    lx_Segment* seg = &ctx->cells;
+    while (index >= (unsigned int)(seg->base + (seg->end - seg->start))) seg = seg->next;
+    return seg->start + (index - seg->base);
+}
+
+typedef struct { lx_Segment* seg; lx_Value* at; } lx_Cursor;
+
+// Hands out the next free slot in traversal order, stepping over persisted cells since they never move
+static unsigned int lx_nextslot(lx_Cursor* cursor) {
+    for (;;) {
+        if (cursor->at == cursor->seg->end) { cursor->seg = cursor->seg->next; cursor->at = cursor->seg->start; continue; }
+        lx_Value* slot = cursor->at++;
+        if (!slot->persist) return cursor->seg->base + (unsigned int)(slot - cursor->seg->start);
+    }
+}
+
+// Assigns every cell reachable from `v` its slot after compaction, walking chains in order so they end up contiguous
+static void lx_order(lx_Ctx* ctx, lx_Value* v, lx_Cursor* cursor) {
+    lx_Segment* seg;
+    while (v && (seg = lx_segmentof(ctx, v)) && !v->forward) {
+        v->forward = (v->persist ? seg->base + (unsigned int)(v - seg->start) : lx_nextslot(cursor)) + 1;
+        if (v->type != LX_LIST && v->type != LX_ENV) return;
+        lx_order(ctx, v->env.name, cursor);
+        lx_order(ctx, v->env.value, cursor);
+        v = v->env.next;
+    }
+}
+
+static lx_Value* lx_forwarded(lx_Ctx* ctx, lx_Value* v) { return v && lx_segmentof(ctx, v) && v->forward ? lx_cellat(ctx, v->forward - 1) : v; }
+
+static void lx_forwardlinks(lx_Ctx* ctx, lx_Value* v) {
+    if (v->type != LX_LIST && v->type != LX_ENV) return;
+    v->env.name = lx_forwarded(ctx, v->env.name);
+    v->env.value = lx_forwarded(ctx, v->env.value);
+    v->env.next = lx_forwarded(ctx, v->env.next);
+}
+
+// Slides every live cell into traversal order at the bottom of cell memory, updating all references held by lx itself
+static int lx_compactcells(lx_Ctx* ctx, lx_Value** root) {
+    int base = 0;
+    for (lx_Segment* seg = &ctx->cells; seg; seg = seg->next) { seg->base = base; base += (int)(seg->end - seg->start); }
+    lx_Cursor cursor = { &ctx->cells, ctx->cells.start };
+
+    for (lx_Value* call = ctx->current; call; call = call->call.last) { lx_order(ctx, call->call.env, &cursor); lx_order(ctx, call->call.callable, &cursor); }
+    for (lx_Value* val = ctx->frame_start; val < ctx->frame_top; val += 2) { lx_order(ctx, val->env.name, &cursor); lx_order(ctx, val->env.value, &cursor); lx_order(ctx, val->env.next, &cursor); }
+    FOR_CELLS(seg, val) if (val->persist) lx_order(ctx, val, &cursor);
+    for (int i = 0; i < ctx->temp_top; i++) lx_order(ctx, ctx->temps[i], &cursor);
+    for (int i = 0; i < LX_HANDLES; i++) lx_order(ctx, ctx->handles[i], &cursor);
+    if (root) lx_order(ctx, *root, &cursor);
+
+    FOR_CELLS(seg, val) if (val->forward) lx_forwardlinks(ctx, val);
+    for (lx_Value* val = ctx->frame_start; val < ctx->frame_top; val += 2) lx_forwardlinks(ctx, val);
+    for (lx_Value* call = ctx->current; call; call = call->call.last) { call->call.env = lx_forwarded(ctx, call->call.env); call->call.callable = lx_forwarded(ctx, call->call.callable); }
+    for (int i = 0; i < ctx->temp_top; i++) ctx->temps[i] = lx_forwarded(ctx, ctx->temps[i]);
+    for (int i = 0; i < LX_HANDLES; i++) ctx->handles[i] = lx_forwarded(ctx, ctx->handles[i]);
+    if (root) *root = lx_forwarded(ctx, *root);
+
+    // Every swap puts one cell in its final slot, anything left without a forward is garbage
+    int n_moved = 0;
+    FOR_CELLS(seg, val) {
+        lx_Value* target;
+        while (val->forward && (target = lx_cellat(ctx, val->forward - 1)) != val) {
+            lx_Value temp = *target;
+            *target = *val;
+            *val = temp;
+            n_moved++;
+        }
+    }
+
+    // Live cells now sit at the bottom of the heap, which usually leaves trailing segments empty
+    for (lx_Segment* seg = &ctx->cells; seg; seg = seg->next) seg->live = 0;
+    FOR_CELLS(seg, val) seg->live += val->forward != 0;
+    lx_shrink(ctx);
+
+    lx_Value** tail = &ctx->free_list;
+    FOR_CELLS(seg, val) {
+        val->mark = 0;
+        if (val->forward) { val->forward = 0; continue; }
+        val->type = LX_FREE;
+        *tail = val;
+        tail = &val->free;
+    }
+    *tail = 0;
+
+    ctx->compacted_at = ctx->collections;
+    return n_moved;
+}
+
+int lx_compact(lx_Ctx* ctx) { return ctx->current ? -1 : lx_compactcells(ctx, 0); }
+
+void lx_setcompact(lx_Ctx* ctx, int every) { ctx->compact_every = every; }
+
+int lx_handle(lx_Ctx* ctx, lx_Value* val) {
+    for (int i = 0; i < LX_HANDLES; i++) if (!ctx->handles[i]) { ctx->handles[i] = val; return i; }
+    return -1;
+}
+
+static int lx_livehandle(lx_Ctx* ctx, int handle) { return handle >= 0 && handle < LX_HANDLES && ctx->handles[handle]; }
+
+lx_Value* lx_gethandle(lx_Ctx* ctx, int handle) { return lx_livehandle(ctx, handle) ? ctx->handles[handle] : 0; }
+void lx_releasehandle(lx_Ctx* ctx, int handle) { if (lx_livehandle(ctx, handle)) ctx->handles[handle] = 0; }
+
 static int lx_symbeq(lx_Value* a, lx_Value* b) {
     if (!a || !b) return 0;
     if (a->type != LX_SYMBOL || b->type != LX_SYMBOL) return 0;
@@ -291,31 +681,80 @@ lx_Value* lx_makenv(lx_Ctx* ctx) {
 
 void lx_persist(lx_Value* val) { val->persist = 1; }
 
-static lx_Value* lx_marktemp(lx_Value* v) { v->mark = 1; return v; }
+// Moves the temporary stack out of the arena into a bigger allocation, when there's an allocator to get one from
+static void lx_growtemps(lx_Ctx* ctx) {
+    if (!ctx->allocator) return;
+    int cap = ctx->temp_cap ? ctx->temp_cap * 2 : LX_TEMP_SLOTS;
+    lx_Value** temps = (lx_Value**)ctx->allocator(ctx->allocator_data, 0, cap * sizeof(lx_Value*));
+    if (!temps) return;
+
+    for (int i = 0; i < ctx->temp_top; i++) temps[i] = ctx->temps[i];
+    if (ctx->temps != (lx_Value**)ctx->cells.end) ctx->allocator(ctx->allocator_data, ctx->temps, 0);
+    ctx->temps = temps;
+    ctx->temp_cap = cap;
+}
+
+// Temporaries stay rooted until the lx_eval that made them returns, once the stack is full the mark alone only covers one collection
+static lx_Value* lx_marktemp(lx_Ctx* ctx, lx_Value* v) {
+    if (ctx->temp_top == ctx->temp_cap) lx_growtemps(ctx);
+    if (ctx->temp_top < ctx->temp_cap) ctx->temps[ctx->temp_top++] = v;
+    else v->mark = 1;
+    return v;
+}
 static lx_Value* lx_releasetemp(lx_Value* v) { v->mark = 1; return v; }
 
-void lx_setenv(lx_Ctx* ctx, lx_Value* env, lx_Value* name, lx_Value* value) {
+static int lx_inframe(lx_Ctx* ctx, lx_Value* v) { return v >= ctx->frame_start && v < ctx->frame_end; }
+
+// Frame links are pushed in pairs, the second cell holding the argument name when one is bound
+static lx_Value* lx_framepush(lx_Ctx* ctx) {
+    if (ctx->frame_end - ctx->frame_top < 2) return 0;
+    lx_Value* link = ctx->frame_top;
+    ctx->frame_top += 2;
+    *link = (lx_Value) { .type = LX_ENV, .env = { .name = 0, .value = 0, .next = 0 } };
+    return link;
+}
+
+static lx_Value* lx_bindenv(lx_Ctx* ctx, lx_Value* env, lx_Value* name, lx_Value* value) {
     lx_Value* prev = env;
     while (env && env->env.name) {
         if (lx_symbeq(env->env.name, name)) {
             env->env.value = value;
-            return;
+            return env;
         }
 
         prev = env;
         env = env->env.next;
     }
 
+    if (!env && lx_inframe(ctx, prev) && prev + 2 == ctx->frame_top) env = lx_framepush(ctx);
     if (!env) { env = lx_alloc(ctx, LX_ENV, 1); env->env.next = 0; }
     if (env != prev) prev->env.next = env;
 
     env->env.name = name;
     env->env.value = value;
+    return env;
 }
 
+// Copies a frame chain onto the heap, used when a frame would outlive its call
+static lx_Value* lx_materialize(lx_Ctx* ctx, lx_Value* frame) {
+    lx_Value* env = lx_makenv(ctx);
+    for (; frame && frame->env.name; frame = frame->env.next) {
+        lx_Value* name = lx_inframe(ctx, frame->env.name) ? lx_marktemp(ctx, lx_promote(ctx, *frame->env.name)) : frame->env.name;
+        lx_bindenv(ctx, lx_marktemp(ctx, env), name, frame->env.value);
+    }
+    return env;
+}
+
+static void lx_bindarg(lx_Ctx* ctx, lx_Value* env, lx_Value name, lx_Value* value) {
+    lx_Value* link = lx_bindenv(ctx, env, &name, lx_stash(ctx, value));
+    if (link->env.name == &name) link->env.name = lx_inframe(ctx, link) ? (link[1] = name, link + 1) : lx_marktemp(ctx, lx_promote(ctx, name));
+}
+
+void lx_setenv(lx_Ctx* ctx, lx_Value* env, lx_Value* name, lx_Value* value) { lx_bindenv(ctx, env, name, lx_stash(ctx, value)); }
+
 void lx_setenvc(lx_Ctx* ctx, lx_Value* env, const char* name, lx_Value* value) {
     lx_Value* lx_name = lx_promote(ctx, (lx_Value) { .type = LX_SYMBOL, .symbol = { .start = name, .len = lx_strlen(name) } });
-    lx_setenv(ctx, env, lx_marktemp(lx_name), lx_marktemp(value));
+    lx_setenv(ctx, env, lx_marktemp(ctx, lx_name), lx_marktemp(ctx, value));
 }
 
 
@@ -334,46 +773,719 @@ lx_Value* lx_getenvc(lx_Value* env, const char* name) {
     return lx_getenv(env, &lx_name);
 }
 
+int lx_truthy(lx_Value* val) {
+    if (!val) return 0;
+    if (val->type == LX_FREE || val->type == LX_NIL) return 0;
+    if (val->type == LX_NUMBER && val->number == 0) return 0;
+    if (val->type == LX_INT && val->integer == 0) return 0;
+    return 1;
+}
+
+lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** end, int eval_symbol, int side_effects);
+
+#ifdef LX_BUILD_JIT
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "LX_BUILD_JIT is only supported on x86-64 Linux"
+#endif
+
+// MAP_ANONYMOUS is an extension strict -std=c11 hides, but this is the first system header lx.c includes so it can still ask for it
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS 0x20 // a host included a system header before lx.c in a strict mode, this is its value on x86-64 Linux
+#endif
+
+#define LX_JIT_ENTRIES 256
+#define LX_JIT_CODE_SIZE (256 * 1024)
+#define LX_JIT_MAX_ARGS 16
+#define LX_JIT_SLOTS 32
+
+// Arguments and the result are passed as raw integers or doubles, `bail` gets set when the call has to be redone by the interpreter
+typedef long long (*lx_Native)(const long long* args, int* bail);
+
+typedef struct {
+    const char* args;
+    const char* body;
+    const char* end; // where the compiled source ends, and a hash of it from `args` on
+    unsigned int hash;
+    int calls;
+    int argc;
+    int failed;
+    int ints; // bit i is set if argument i was compiled as an integer, otherwise it was a double
+    int type;
+    void* code;
+} lx_JitEntry;
+
+typedef struct {
+    lx_JitEntry entries[LX_JIT_ENTRIES];
+    int entry_count;
+    int compiled;
+    unsigned char* code;
+    int used;
+    int overflow;
+    int stuck; // set if the code couldn't be made executable again after a compile, nothing native runs from then on
+
+    // Arguments and locals each get a stack slot with a fixed type, `defined` has a bit set for every slot that's sure to be assigned so far
+    const char* names[LX_JIT_SLOTS];
+    int lens[LX_JIT_SLOTS];
+    int types[LX_JIT_SLOTS];
+    int slots;
+    unsigned int defined;
+} lx_Jit;
+
+static long long lx_jitmapsize(void) { return lx_align(sizeof(lx_Jit), 4096) + LX_JIT_CODE_SIZE; }
+
+int lx_jit(lx_Ctx* ctx, int enable) {
+    if (!enable) {
+        if (ctx->jit) munmap(ctx->jit, lx_jitmapsize());
+        ctx->jit = 0;
+        return 0;
+    }
+    if (ctx->jit) return 1;
+
+    void* mem = mmap(0, lx_jitmapsize(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return 0;
+    lx_Jit* jit = (lx_Jit*)mem;
+    jit->code = (unsigned char*)mem + lx_align(sizeof(lx_Jit), 4096);
+    if (mprotect(jit->code, LX_JIT_CODE_SIZE, PROT_READ | PROT_EXEC)) {
+        munmap(mem, lx_jitmapsize());
+        return 0;
+    }
+    ctx->jit = jit;
+    return 1;
+}
+
+int lx_jitcount(lx_Ctx* ctx) { return ctx->jit ? ((lx_Jit*)ctx->jit)->compiled : 0; }
+
+static void lx_emit(lx_Jit* jit, const char* bytes, int len) {
+    if (jit->used + len > LX_JIT_CODE_SIZE) { jit->overflow = 1; return; }
+    for (int i = 0; i < len; i++) jit->code[jit->used++] = (unsigned char)bytes[i];
+}
+
+static void lx_emit32(lx_Jit* jit, int v) { char b[4] = { (char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24) }; lx_emit(jit, b, 4); }
+static void lx_patch32(lx_Jit* jit, int at) { int rel = jit->used - (at + 4); for (int i = 0; i < 4; i++) jit->code[at + i] = (unsigned char)(rel >> (i * 8)); }
+
+#define EMIT(...) lx_emit(jit, (const char[]) { __VA_ARGS__ }, sizeof((const char[]) { __VA_ARGS__ }))
+
+// mov rax, imm64
+static void lx_emitimm(lx_Jit* jit, unsigned long long bits) {
+    EMIT(0x48, 0xB8);
+    for (int i = 0; i < 8; i++) EMIT((char)(bits >> (i * 8)));
+}
+
+// mov rax, imm64 ; movq xmm{reg}, rax
+static void lx_emitconst(lx_Jit* jit, double value, int reg) {
+    union { double d; unsigned long long u; } bits = { .d = value };
+    lx_emitimm(jit, bits.u);
+    EMIT(0x66, 0x48, 0x0F, 0x6E, (char)(0xC0 | (reg << 3)));
+}
+
+// Turns the all-ones compare mask in xmm0 into 1 or 0 in rax
+static void lx_emitbool(lx_Jit* jit) {
+    EMIT(0x66, 0x48, 0x0F, 0x7E, 0xC0, 0x83, 0xE0, 0x01); // movq rax, xmm0 ; and eax, 1
+}
+
+// Skips over a bail out when the condition `jcc` holds - the bail out flags the call through rsi and returns, the interpreter then runs it from the start
+static void lx_emitguard(lx_Jit* jit, char jcc) {
+    EMIT(jcc, 0x08, 0xC7, 0x06, 0x01, 0x00, 0x00, 0x00, 0xC9, 0xC3); // j<cc> +8 ; mov dword [rsi], 1 ; leave ; ret
+}
+
+// Tests a value of `type` and jumps if it's falsy, returns where to patch the jump's target in
+static int lx_emitfalsy(lx_Jit* jit, int type) {
+    if (type == LX_INT) EMIT(0x48, 0x85, 0xC0, 0x0F, 0x84); // test rax, rax ; je
+    else EMIT(0x66, 0x0F, 0x57, 0xC9, 0x66, 0x0F, 0x2E, 0xC1, 0x7A, 0x06, 0x0F, 0x84); // xorpd xmm1, xmm1 ; ucomisd xmm0, xmm1 ; jp +6 (nan is truthy) ; je
+    int at = jit->used;
+    lx_emit32(jit, 0);
+    return at;
+}
+
+// Loads a slot into rax or xmm0 depending on its type, or stores it from there
+static void lx_emitslot(lx_Jit* jit, int slot, int store) {
+    if (jit->types[slot] == LX_INT) EMIT(0x48, store ? 0x89 : 0x8B, 0x85); // mov rax, [rbp + disp32] (or the other way around)
+    else EMIT(0xF2, 0x0F, store ? 0x11 : 0x10, 0x85); // movsd xmm0, [rbp + disp32] (or the other way around)
+    lx_emit32(jit, -8 * (slot + 1));
+}
+
+static int lx_jitslot(lx_Jit* jit, const char* name, int len) {
+    for (int slot = 0; slot < jit->slots; slot++) {
+        if (jit->lens[slot] != len) continue;
+        int i = 0;
+        while (i < len && jit->names[slot][i] == name[i]) i++;
+        if (i == len) return slot;
+    }
+    return -1;
+}
+
+static int lx_jitexpr(lx_Jit* jit, const char** src);
+
+// Compiles operands a and b and returns the type arithmetic on them has - two integers end up in rax and rcx, anything else as doubles in xmm0 and xmm1
+static int lx_jitab(lx_Jit* jit, const char** src) {
+    int a = lx_jitexpr(jit, src);
+    if (a != LX_INT && a != LX_NUMBER) return 0;
+    if (a == LX_NUMBER) EMIT(0x66, 0x48, 0x0F, 0x7E, 0xC0); // movq rax, xmm0
+    EMIT(0x50); // push rax
+    int b = lx_jitexpr(jit, src);
+    if (b != LX_INT && b != LX_NUMBER) return 0;
+    if (a == LX_INT && b == LX_INT) { EMIT(0x48, 0x89, 0xC1, 0x58); return LX_INT; } // mov rcx, rax ; pop rax
+
+    if (b == LX_INT) EMIT(0xF2, 0x48, 0x0F, 0x2A, 0xC8); // cvtsi2sd xmm1, rax
+    else EMIT(0x66, 0x0F, 0x28, 0xC8); // movapd xmm1, xmm0
+    EMIT(0x58); // pop rax
+    if (a == LX_INT) EMIT(0xF2, 0x48, 0x0F, 0x2A, 0xC0); // cvtsi2sd xmm0, rax
+    else EMIT(0x66, 0x48, 0x0F, 0x6E, 0xC0); // movq xmm0, rax
+    return LX_NUMBER;
+}
+
+// `= name value` with a plain name binds a local in the function's own frame, which becomes a slot here
+static int lx_jitassign(lx_Jit* jit, const char** src) {
+    const char* name = *src;
+    while (lx_isspace(*name)) name++;
+    if (!lx_isalpha(*name)) return 0;
+    int len = lx_word(name);
+    *src = name + len;
+
+    int type = lx_jitexpr(jit, src);
+    if (type != LX_INT && type != LX_NUMBER) return 0;
+    int slot = lx_jitslot(jit, name, len);
+    if (slot < 0) {
+        if (jit->slots == LX_JIT_SLOTS) return 0;
+        slot = jit->slots++;
+        jit->names[slot] = name;
+        jit->lens[slot] = len;
+        jit->types[slot] = type;
+    }
+    if (jit->types[slot] != type) return 0; // every store has to agree with the loads on the slot's type
+    lx_emitslot(jit, slot, 1);
+    jit->defined |= 1u << slot;
+    return LX_NIL;
+}
+
+// Mirrors the numeric subset of lx_eval, bailing out on anything that could touch the heap or any environment but the function's own locals.
+// Returns the type the expression evaluates to, or 0 if it can't be compiled - integers end up in rax and doubles in xmm0.
+// Nil also stands in for the value of a loop, which depends on how often it ran, so it can only be thrown away
+static int lx_jitexpr(lx_Jit* jit, const char** src) {
+    const char* start = *src;
+    while (lx_isspace(*start)) start++;
+
+    char c = *start++;
+    *src = start;
+    int type = LX_INT;
+    if (*start == c && (c == '<' || c == '>')) return 0; // the shifts stay interpreted
+    if (*start == c && (c == '/' || c == '%' || c == '&' || c == '|' || c == '^')) {
+        (*src)++;
+        if (lx_jitab(jit, src) != LX_INT) return 0; // and so do the other doubled operators unless both sides are integers
+        if (c == '/' || c == '%') {
+            EMIT(0x48, 0x85, 0xC9); // test rcx, rcx
+            lx_emitguard(jit, 0x75); // jne, dividing by 0 gives nil
+            EMIT(0x48, 0x83, 0xF9, 0xFF, 0x75, 0x05); // cmp rcx, -1 ; jne (idiv traps on the smallest integer over -1)
+            if (c == '/') EMIT(0x48, 0xF7, 0xD8, 0xEB, 0x05); // neg rax ; jmp
+            else EMIT(0x48, 0x31, 0xC0, 0xEB, 0x08); // xor rax, rax ; jmp
+            EMIT(0x48, 0x99, 0x48, 0xF7, 0xF9); // cqo ; idiv rcx
+            if (c == '%') EMIT(0x48, 0x89, 0xD0); // mov rax, rdx
+        } else EMIT(0x48, c == '&' ? 0x21 : c == '|' ? 0x09 : 0x31, 0xC8); // and/or/xor rax, rcx
+        return jit->overflow ? 0 : LX_INT;
+    }
+
+    switch (c) {
+    case '+': if (!(type = lx_jitab(jit, src))) return 0; if (type == LX_INT) EMIT(0x48, 0x01, 0xC8); else EMIT(0xF2, 0x0F, 0x58, 0xC1); break;
+    case '-': if (!(type = lx_jitab(jit, src))) return 0; if (type == LX_INT) EMIT(0x48, 0x29, 0xC8); else EMIT(0xF2, 0x0F, 0x5C, 0xC1); break;
+    case '*': if (!(type = lx_jitab(jit, src))) return 0; if (type == LX_INT) EMIT(0x48, 0x0F, 0xAF, 0xC1); else EMIT(0xF2, 0x0F, 0x59, 0xC1); break;
+    case '/':
+        if (!(type = lx_jitab(jit, src))) return 0;
+        if (type == LX_INT) EMIT(0xF2, 0x48, 0x0F, 0x2A, 0xC0, 0xF2, 0x48, 0x0F, 0x2A, 0xC9); // cvtsi2sd xmm0, rax ; cvtsi2sd xmm1, rcx
+        EMIT(0xF2, 0x0F, 0x5E, 0xC1);
+        type = LX_NUMBER;
+        break;
+    case '<': case '>': case '=': {
+        int equal = *start == '=';
+        if (c == '=' && !equal) { type = lx_jitassign(jit, src); break; }
+        *src += equal;
+        if (!(type = lx_jitab(jit, src))) return 0;
+        if (type == LX_INT) {
+            char setcc = c == '=' ? 0x94 : c == '<' ? (equal ? 0x9E : 0x9C) : (equal ? 0x9D : 0x9F);
+            EMIT(0x48, 0x39, 0xC8, 0x0F, setcc, 0xC0, 0x0F, 0xB6, 0xC0); // cmp rax, rcx ; set<cc> al ; movzx eax, al
+            break;
+        }
+        // cmpsd with predicate 0 (eq), 1 (lt) or 2 (le), swapping operands for > and >=
+        char predicate = c == '=' ? 0 : equal ? 2 : 1;
+        if (c == '>') EMIT(0xF2, 0x0F, 0xC2, 0xC8, predicate, 0x66, 0x0F, 0x28, 0xC1);
+        else EMIT(0xF2, 0x0F, 0xC2, 0xC1, predicate);
+        lx_emitbool(jit);
+        type = LX_INT;
+        break;
+    }
+    case '&': case '|':
+        if (!(type = lx_jitab(jit, src))) return 0;
+        if (type == LX_INT) {
+            EMIT(0x48, 0x85, 0xC0, 0x0F, 0x95, 0xC0, 0x48, 0x85, 0xC9, 0x0F, 0x95, 0xC1); // test rax, rax ; setne al ; test rcx, rcx ; setne cl
+            EMIT(c == '&' ? 0x20 : 0x08, 0xC8, 0x0F, 0xB6, 0xC0); // and/or al, cl ; movzx eax, al
+            break;
+        }
+        EMIT(0x66, 0x0F, 0x57, 0xD2, 0xF2, 0x0F, 0xC2, 0xC2, 0x04, 0xF2, 0x0F, 0xC2, 0xCA, 0x04); // xorpd xmm2, xmm2 ; cmpneqsd xmm0, xmm2 ; cmpneqsd xmm1, xmm2
+        if (c == '&') EMIT(0x66, 0x0F, 0x54, 0xC1); else EMIT(0x66, 0x0F, 0x56, 0xC1);
+        lx_emitbool(jit);
+        type = LX_INT;
+        break;
+    case '!': {
+        int operand = lx_jitexpr(jit, src);
+        if (operand == LX_INT) { EMIT(0x48, 0x85, 0xC0, 0x0F, 0x94, 0xC0, 0x0F, 0xB6, 0xC0); break; } // test rax, rax ; sete al ; movzx eax, al
+        if (operand != LX_NUMBER) return 0;
+        EMIT(0x66, 0x0F, 0x57, 0xD2, 0xF2, 0x0F, 0xC2, 0xC2, 0x00); // xorpd xmm2, xmm2 ; cmpeqsd xmm0, xmm2
+        lx_emitbool(jit);
+        break;
+    }
+    case '_': {
+        int operand = lx_jitexpr(jit, src);
+        if (operand == LX_INT) break; // already whole
+        if (operand != LX_NUMBER) return 0;
+        lx_emitconst(jit, 0.5, 2);
+        EMIT(0x66, 0x0F, 0x57, 0xC9, 0x66, 0x0F, 0x2E, 0xC1, 0x0F, 0x87); // xorpd xmm1, xmm1 ; ucomisd xmm0, xmm1 ; ja
+        int positive = jit->used; lx_emit32(jit, 0);
+        EMIT(0xF2, 0x0F, 0x5C, 0xC2, 0xE9); // subsd xmm0, xmm2 ; jmp
+        int done = jit->used; lx_emit32(jit, 0);
+        lx_patch32(jit, positive);
+        EMIT(0xF2, 0x0F, 0x58, 0xC2); // addsd xmm0, xmm2
+        lx_patch32(jit, done);
+        EMIT(0xF2, 0x48, 0x0F, 0x2C, 0xC0, 0x48, 0xB9, 0, 0, 0, 0, 0, 0, 0, 0x80, 0x48, 0x39, 0xC8); // cvttsd2si rax, xmm0 ; mov rcx, 1 << 63 ; cmp rax, rcx
+        lx_emitguard(jit, 0x75); // jne, nan and anything out of range stays a double, which only the interpreter can return here
+        break;
+    }
+    case '?': {
+        int cond = lx_jitexpr(jit, src);
+        if (cond != LX_INT && cond != LX_NUMBER) return 0;
+        int falsy = lx_emitfalsy(jit, cond);
+        unsigned int defined = jit->defined;
+        if (!(type = lx_jitexpr(jit, src))) return 0;
+        unsigned int taken = jit->defined;
+        jit->defined = defined;
+        EMIT(0xE9); // jmp
+        int done = jit->used; lx_emit32(jit, 0);
+        lx_patch32(jit, falsy);
+        if (lx_jitexpr(jit, src) != type) return 0; // both branches have to agree on the result type
+        jit->defined &= taken; // only what both branches assign is sure to be set afterwards
+        lx_patch32(jit, done);
+        break;
+    }
+    case '^': {
+        int loop = jit->used;
+        int cond = lx_jitexpr(jit, src);
+        if (cond != LX_INT && cond != LX_NUMBER) return 0;
+        int exit = lx_emitfalsy(jit, cond);
+        unsigned int defined = jit->defined;
+        if (!lx_jitexpr(jit, src)) return 0;
+        jit->defined = defined; // the body might never run
+        EMIT(0xE9); // jmp
+        lx_emit32(jit, loop - (jit->used + 4));
+        lx_patch32(jit, exit);
+        type = LX_NIL;
+        break;
+    }
+    case '(':
+        type = LX_NIL;
+        for (;;) {
+            while (lx_isspace(**src)) (*src)++;
+            if (**src == '`') { while (**src && **src != '\n') (*src)++; continue; }
+            if (!**src || **src == ')') break;
+            if (!(type = lx_jitexpr(jit, src))) return 0;
+        }
+        if (**src != ')') return 0;
+        (*src)++;
+        break;
+    default:
+        start--;
+        if (lx_isdigit(c)) {
+            lx_Value literal = lx_parseliteral(start, src);
+            type = literal.type;
+            if (type == LX_INT) lx_emitimm(jit, (unsigned long long)literal.integer);
+            else lx_emitconst(jit, literal.number, 0);
+            break;
+        }
+        if (!lx_isalpha(c)) return 0;
+
+        int len = lx_word(start), slot = lx_jitslot(jit, start, len);
+        if (slot < 0 || !(jit->defined >> slot & 1)) return 0; // anything else is looked up outside the function
+        lx_emitslot(jit, slot, 0);
+        *src = start + len;
+        type = jit->types[slot];
+        break;
+    }
+
+    return jit->overflow ? 0 : type;
+}
+
+static unsigned int lx_jithash(const char* start, const char* end) {
+    unsigned int hash = 2166136261u;
+    while (start < end) hash = (hash ^ (unsigned char)*start++) * 16777619u;
+    return hash;
+}
+
+static int lx_jitcompile(lx_Jit* jit, lx_JitEntry* entry, lx_Value* fn, int ints) {
+    const char* args = fn->fn.arg_start;
+    int many = *args == '(';
+    args += many;
+
+    jit->slots = 0;
+    for (;;) {
+        while (lx_isspace(*args)) args++;
+        int len = lx_word(args);
+        if (!len) break;
+        if (jit->slots == LX_JIT_MAX_ARGS) return 0;
+        if (lx_jitslot(jit, args, len) >= 0) return 0;
+        jit->names[jit->slots] = args;
+        jit->lens[jit->slots] = len;
+        jit->types[jit->slots] = ints >> jit->slots & 1 ? LX_INT : LX_NUMBER;
+        jit->slots++;
+        args += len;
+        if (!many) break;
+    }
+    int argc = jit->slots;
+    jit->defined = (1u << argc) - 1;
+
+    int code_start = jit->used;
+    if (mprotect(jit->code, LX_JIT_CODE_SIZE, PROT_READ | PROT_WRITE)) return 0;
+    EMIT(0x55, 0x48, 0x89, 0xE5, 0x48, 0x81, 0xEC); // push rbp ; mov rbp, rsp ; sub rsp, imm32
+    lx_emit32(jit, LX_JIT_SLOTS * 8);
+    for (int i = 0; i < argc; i++) {
+        EMIT(0x48, 0x8B, 0x87); lx_emit32(jit, i * 8); // mov rax, [rdi + disp32]
+        EMIT(0x48, 0x89, 0x85); lx_emit32(jit, -8 * (i + 1)); // mov [rbp + disp32], rax
+    }
+    const char* body = fn->fn.body_start;
+    int type = lx_jitexpr(jit, &body);
+    if (type == LX_NUMBER) EMIT(0x66, 0x48, 0x0F, 0x7E, 0xC0); // movq rax, xmm0
+    EMIT(0xC9, 0xC3); // leave ; ret
+    int ok = (type == LX_INT || type == LX_NUMBER) && !jit->overflow;
+    if (!ok) jit->used = code_start;
+    jit->overflow = 0;
+    if (mprotect(jit->code, LX_JIT_CODE_SIZE, PROT_READ | PROT_EXEC)) jit->stuck = 1;
+    if (!ok || jit->stuck) return 0;
+
+    entry->argc = argc;
+    entry->ints = ints;
+    entry->type = type;
+    entry->code = jit->code + code_start;
+    entry->end = body;
+    entry->hash = lx_jithash(fn->fn.arg_start, body);
+    jit->compiled++;
+    return 1;
+}
+
+#undef EMIT
+
+// The function value remembers its entry, so copies of it share the entry along with the code (the check catches values still pointing
+// into the table from before the tier was last turned off). Every evaluation of `'...` makes a fresh value though, which finds the entry
+// for the same source through its pointers, as long as the source there still reads the same as when it was compiled
+static lx_JitEntry* lx_jitentry(lx_Jit* jit, lx_Value* fn) {
+    lx_JitEntry* entry = fn->fn.jit ? &jit->entries[fn->fn.jit - 1] : 0;
+    if (entry && entry->args == fn->fn.arg_start && entry->body == fn->fn.body_start) return entry;
+
+    for (entry = jit->entries; entry < jit->entries + jit->entry_count; entry++) {
+        if (entry->args != fn->fn.arg_start || entry->body != fn->fn.body_start) continue;
+        if (entry->code && lx_jithash(entry->args, entry->end) != entry->hash) *entry = (lx_JitEntry) { .args = entry->args, .body = entry->body }; // new source in the same place
+        fn->fn.jit = (int)(entry - jit->entries) + 1;
+        return entry;
+    }
+    if (jit->entry_count == LX_JIT_ENTRIES) return 0;
+
+    entry = &jit->entries[jit->entry_count++];
+    entry->args = fn->fn.arg_start;
+    entry->body = fn->fn.body_start;
+    fn->fn.jit = jit->entry_count;
+    return entry;
+}
+
+// Runs `fn` natively once it's hot, specialised on which of its arguments were integers and which were doubles on that call.
+// Returns 0 to fall back to the interpreter whenever the arguments bound in `env` don't match, or the native code bailed out
+static lx_Value* lx_jitcall(lx_Ctx* ctx, lx_Value* fn, lx_Value* env) {
+    lx_Jit* jit = ctx->jit;
+    lx_JitEntry* entry = jit && !jit->stuck ? lx_jitentry(jit, fn) : 0;
+    if (!entry || entry->failed) return 0;
+    if (!entry->code && ++entry->calls < LX_JIT_THRESHOLD) return 0;
+
+    long long args[LX_JIT_MAX_ARGS];
+    int argc = 0, ints = 0;
+    for (; env && env->env.value; env = env->env.next, argc++) {
+        lx_Value* arg = env->env.value;
+        if (argc == LX_JIT_MAX_ARGS || (arg->type != LX_INT && arg->type != LX_NUMBER)) return 0;
+        union { double d; long long i; } bits = { .d = arg->number };
+        if (arg->type == LX_INT) { ints |= 1 << argc; bits.i = arg->integer; }
+        args[argc] = bits.i;
+    }
+    if (!entry->code && !lx_jitcompile(jit, entry, fn, ints)) { entry->failed = 1; return 0; }
+    if (argc != entry->argc || ints != entry->ints) return 0;
+
+    int bail = 0;
+    union { long long i; double d; } result = { .i = ((lx_Native)entry->code)(args, &bail) };
+    if (bail) return 0;
+    return entry->type == LX_INT ? lx_int(ctx, result.i) : lx_number(ctx, result.d);
+}
+
+#else
+#define lx_jitcall(ctx, fn, env) 0
+#endif
+
+// Calls `fn` from native code, binding `argv` to its arguments in order
+static lx_Value* lx_apply(lx_Ctx* ctx, lx_Value* fn, lx_Value** argv, int argc) {
+    if (fn->type != LX_FN && fn->type != LX_CFN) return &lx_nil_;
+    const char* args = fn->type == LX_FN ? fn->fn.arg_start : fn->cfn.args,* end;
+    int many = *args == '(';
+
+    lx_Value* frame_top = ctx->frame_top,* frame = lx_framepush(ctx);
+    int temp_top = ctx->temp_top;
+    lx_Value call = { .type = LX_CALL, .call = { .last = ctx->current, .env = frame ? frame : lx_makenv(ctx), .callable = fn } };
+    for (int i = 0, len; i < argc; i++) {
+        args += many && !i;
+        while (lx_isspace(*args)) args++;
+        if (!(len = lx_word(args))) break;
+        lx_bindarg(ctx, call.call.env, (lx_Value) { .type = LX_SYMBOL, .symbol = { .start = args, .len = len } }, lx_marktemp(ctx, argv[i]));
+        args += len;
+        if (!many) break;
+    }
+
+    ctx->current = &call;
+    lx_Value* result = fn->type == LX_CFN ? fn->cfn.cfn(ctx, call.call.env) : lx_jitcall(ctx, fn, call.call.env);
+    if (!result) result = fn->type == LX_FN ? lx_eval(ctx, &call, fn->fn.body_start, &end, 1, 1) : &lx_nil_; // a native returning NULL gives nil
+    if (lx_inframe(ctx, result)) result = lx_materialize(ctx, result);
+    ctx->current = call.call.last;
+    ctx->frame_top = frame_top;
+    ctx->temp_top = temp_top;
+    return result;
+}
+
+static int lx_compare(lx_Value* a, lx_Value* b) {
+    if (a->type == LX_INT && b->type == LX_INT) return a->integer < b->integer ? -1 : a->integer > b->integer;
+    if (lx_isnumber(a) && lx_isnumber(b)) return lx_getnumber(a) < lx_getnumber(b) ? -1 : lx_getnumber(a) > lx_getnumber(b);
+    if (a->type != b->type) return a->type < b->type ? -1 : 1;
+    if (a->type != LX_STRING) return 0;
+    for (int i = 0; i < a->string.len && i < b->string.len; i++) if (a->string.start[i] != b->string.start[i]) return a->string.start[i] < b->string.start[i] ? -1 : 1;
+    return a->string.len < b->string.len ? -1 : a->string.len > b->string.len;
+}
+
+static int lx_equal(lx_Value* a, lx_Value* b) { return a == b || (((lx_isnumber(a) && lx_isnumber(b)) || (a->type == b->type && a->type == LX_STRING)) && !lx_compare(a, b)); }
+
+static int lx_before(lx_Ctx* ctx, lx_Value* fn, lx_Value* a, lx_Value* b) {
+    if (!fn) return lx_compare(a, b) < 0;
+    lx_Value* argv[2] = { a, b };
+    return lx_truthy(lx_apply(ctx, fn, argv, 2));
+}
+
+// Lists are identified by their first cell, so after relinking swap whichever cell ended up first back into that spot
+static void lx_keephead(lx_Value* head, lx_Value* first) {
+    if (first == head) return;
+    lx_Value* prev = first;
+    while (prev->list.next != head) prev = prev->list.next;
+
+    lx_Value* value = head->list.value,* next = head->list.next;
+    head->list.value = first->list.value;
+    first->list.value = value;
+    head->list.next = prev == first ? first : first->list.next;
+    first->list.next = next;
+    if (prev != first) prev->list.next = first;
+}
+
+// Bottom-up merge sort that moves cells within a single chain hanging off `root`, so every cell stays reachable if a comparator triggers a collection
+static void lx_sortlist(lx_Ctx* ctx, lx_Value* root, lx_Value* fn) {
+    int len = 0;
+    for (lx_Value* cell = root->list.next; cell; cell = cell->list.next) len++;
+
+    for (int width = 1; width < len; width *= 2) {
+        lx_Value* out = root;
+        while (out->list.next) {
+            lx_Value* a = out->list.next,* a_last = a;
+            for (int i = 1; i < width && a_last->list.next; i++) a_last = a_last->list.next;
+            lx_Value* b = a_last->list.next,* b_end = b;
+            if (!b) break;
+            for (int i = 0; i < width && b_end; i++) b_end = b_end->list.next;
+
+            for (;;) {
+                if (lx_before(ctx, fn, b->list.value, a->list.value)) {
+                    lx_Value* cell = b;
+                    b = a_last->list.next = cell->list.next;
+                    cell->list.next = a;
+                    out = out->list.next = cell;
+                    if (b == b_end) { out = a_last; break; }
+                } else {
+                    out = a;
+                    if (a == a_last) { while (out->list.next != b_end) out = out->list.next; break; }
+                    a = a->list.next;
+                }
+            }
+        }
+    }
+}
+
+static lx_Value* lx_stdsort(lx_Ctx* ctx, lx_Value* fn, lx_Value* list) {
+    if (!lx_islist(list) || (fn && fn->type != LX_FN && fn->type != LX_CFN)) return &lx_nil_;
+    if (!list->list.value) return list;
+
+    lx_Value stack_root = { .type = LX_LIST },* root = fn ? lx_list(ctx) : &stack_root;
+    root->persist = 1;
+    root->list.next = list;
+    lx_sortlist(ctx, root, fn);
+    lx_keephead(list, root->list.next);
+    root->persist = 0;
+    root->list.next = 0;
+    return list;
+}
+
+static lx_Value* lx_std_sort(lx_Ctx* ctx, lx_Value* env) { return lx_stdsort(ctx, 0, lx_getenvc(env, "xs")); }
+static lx_Value* lx_std_sortby(lx_Ctx* ctx, lx_Value* env) { return lx_stdsort(ctx, lx_getenvc(env, "fn"), lx_getenvc(env, "xs")); }
+
+static lx_Value* lx_std_reverse(lx_Ctx* ctx, lx_Value* env) {
+    (void)ctx;
+    lx_Value* list = lx_getenvc(env, "xs"),* prev = 0;
+    if (!lx_islist(list)) return &lx_nil_;
+    if (!list->list.value) return list;
+
+    for (lx_Value* cell = list,* next; cell; cell = next) { next = cell->list.next; cell->list.next = prev; prev = cell; }
+    lx_keephead(list, prev);
+    return list;
+}
+
+// Copies the items of `list` from `from` up to `to` onto the end of `tail`
+static lx_Value* lx_copyrange(lx_Ctx* ctx, lx_Value* tail, lx_Value* list, int from, int to) {
+    if (!lx_islist(list) || !list->list.value) return tail;
+    for (int i = 0; list && i < to; i++, list = list->list.next) if (i >= from) tail = lx_listappend(ctx, tail, list->list.value);
+    return tail;
+}
+
+static lx_Value* lx_std_slice(lx_Ctx* ctx, lx_Value* env) {
+    lx_Value* from = lx_getenvc(env, "from"),* to = lx_getenvc(env, "to");
+    if (!lx_isnumber(from) || !lx_isnumber(to)) return &lx_nil_;
+
+    lx_Value* result = lx_list(ctx);
+    result->persist = 1;
+    lx_copyrange(ctx, result, lx_getenvc(env, "xs"), (int)lx_getint(from), (int)lx_getint(to));
+    result->persist = 0;
+    return result;
+}
+
+static lx_Value* lx_std_concat(lx_Ctx* ctx, lx_Value* env) {
+    lx_Value* result = lx_list(ctx);
+    result->persist = 1;
+    lx_copyrange(ctx, lx_copyrange(ctx, result, lx_getenvc(env, "xs"), 0, 0x7fffffff), lx_getenvc(env, "ys"), 0, 0x7fffffff);
+    result->persist = 0;
+    return result;
+}
+
+static lx_Value* lx_std_find(lx_Ctx* ctx, lx_Value* env) {
+    lx_Value* list = lx_getenvc(env, "xs"),* val = lx_getenvc(env, "x");
+    if (!lx_islist(list) || !list->list.value) return &lx_nil_;
+    for (int i = 0; list; i++, list = list->list.next) if (lx_equal(list->list.value, val)) return lx_int(ctx, i);
+    return &lx_nil_;
+}
+
+static lx_Value* lx_std_filter(lx_Ctx* ctx, lx_Value* env) {
+    lx_Value* list = lx_getenvc(env, "xs"),* fn = lx_getenvc(env, "fn");
+    if (!lx_islist(list) || (fn->type != LX_FN && fn->type != LX_CFN)) return &lx_nil_;
+    if (!list->list.value) return list;
+
+    lx_Value* write = list,* last = 0;
+    for (lx_Value* read = list; read; read = read->list.next) {
+        lx_Value* item = read->list.value;
+        if (!lx_truthy(lx_apply(ctx, fn, &item, 1))) continue;
+        write->list.value = item;
+        last = write;
+        write = write->list.next;
+    }
+
+    if (last) last->list.next = 0;
+    else list->list.value = list->list.next = 0;
+    return list;
+}
+
+#define LX_STD(name, args) { .type = LX_CFN, .cfn = { args, lx_std_##name } }
+static lx_Value lx_stdfns[] = { LX_STD(sort, "xs"), LX_STD(sortby, "(xs fn)"), LX_STD(reverse, "xs"), LX_STD(slice, "(xs from to)"), LX_STD(concat, "(xs ys)"), LX_STD(find, "(xs x)"), LX_STD(filter, "(xs fn)") };
+#undef LX_STD
+
+#define LX_STD(name) { .type = LX_SYMBOL, .symbol = { #name, sizeof(#name) - 1 } }
+static lx_Value lx_stdnames[] = { LX_STD(sort), LX_STD(sortby), LX_STD(reverse), LX_STD(slice), LX_STD(concat), LX_STD(find), LX_STD(filter) };
+#undef LX_STD
+
+#define LX_STD(i, next) { .type = LX_ENV, .env = { &lx_stdnames[i], &lx_stdfns[i], next } }
+static lx_Value lx_std[] = { LX_STD(0, &lx_std[1]), LX_STD(1, &lx_std[2]), LX_STD(2, &lx_std[3]), LX_STD(3, &lx_std[4]), LX_STD(4, &lx_std[5]), LX_STD(5, &lx_std[6]), LX_STD(6, 0) };
+#undef LX_STD
+
+// Names that aren't found anywhere in the call chain fall back to the builtins
 static lx_Value* lx_getcall(lx_Value* call, lx_Value* name) {
     lx_Value* result = lx_getenv(call->call.env, name);
     if (result->type != LX_NIL) return result;
 
-    if (call->call.last == 0) return &lx_nil_;
+    if (call->call.last == 0) return lx_getenv(lx_std, name);
     return lx_getcall(call->call.last, name);
 }
 
-int lx_truthy(lx_Value* val) {
-    if (!val) return 0;
-    if (val->type == LX_FREE || val->type == LX_NIL) return 0;
-    if (val->type == LX_NUMBER && val->number == 0) return 0;
-    return 1;
+
+
+static long long lx_shift(long long n, long long left) {
+    if (left >= 64) return 0;
+    if (left <= -64) return n < 0 ? -1 : 0;
+    return left >= 0 ? (long long)((unsigned long long)n << left) : n >> -left;
 }
 
+// The doubled operators - `//` and `%%` truncate like C and fall back to doubles when mixed, the bitwise ones take doubles only if they're whole
+static lx_Value* lx_intop(lx_Ctx* ctx, char op, lx_Value* a, lx_Value* b) {
+    if (!lx_isnumber(a) || !lx_isnumber(b)) return &lx_nil_;
+    if (a->type != LX_INT || b->type != LX_INT) {
+        double x = lx_getnumber(a), y = lx_getnumber(b);
+        if (op == '/' || op == '%') {
+            double quotient = x / y;
+            if (quotient > -9223372036854775808.0 && quotient < 9223372036854775807.0) quotient = (double)(long long)quotient;
+            return lx_number(ctx, op == '/' ? quotient : x - quotient * y);
+        }
+        if (!lx_whole(x) || !lx_whole(y)) return &lx_nil_;
+        return lx_intop(ctx, op, &(lx_Value) { .type = LX_INT, .integer = (long long)x }, &(lx_Value) { .type = LX_INT, .integer = (long long)y });
+    }
 
+    long long x = a->integer, y = b->integer;
+    switch (op) {
+    case '/': case '%':
+        if (y == 0) return &lx_nil_;
+        if (y == -1) return lx_int(ctx, op == '/' ? (long long)(0 - (unsigned long long)x) : 0);
+        return lx_int(ctx, op == '/' ? x / y : x % y);
+    case '<': return lx_int(ctx, lx_shift(x, y));
+    case '>': return lx_int(ctx, lx_shift(x, y < -64 ? 64 : -y));
+    case '&': return lx_int(ctx, x & y);
+    case '|': return lx_int(ctx, x | y);
+    case '^': return lx_int(ctx, x ^ y);
+    }
+    return &lx_nil_;
+}
 
 #define WRITE_END (end ? (*end = start, 0) : 0)
 
 #define BUBBLE_EOF(name, expr) \
-    lx_Value* ##name = (expr); if(##name->type == LX_EOF) { return &lx_eof; }
+    lx_Value* name = (expr); if(name->type == LX_EOF) { return &lx_eof; }
 
-#define GET_AB                                                                \
-BUBBLE_EOF(a, lx_marktemp(lx_eval(ctx, call, start, &next, 1, side_effects))) \
+#define GET_AB                                                                    \
+BUBBLE_EOF(a, lx_marktemp(ctx, lx_eval(ctx, call, start, &next, 1, side_effects))) \
 BUBBLE_EOF(b, lx_eval(ctx, call, next, end, 1, side_effects))                                        
 
-#define ARITH_OP(op)                                                               \
-GET_AB                                                                             \
-if (a->type != b->type) { return &lx_nil_; }                                       \
-if (a->type == LX_NUMBER) {                                                        \
-    double result = a->number ##op b->number;                                      \
-    return lx_promote(ctx, (lx_Value) { .type = LX_NUMBER, .number = result });    \
+// Two integers stay exact (wrapping around on overflow), anything mixed with a double becomes one
+#define ARITH_OP(op)                                                                                \
+GET_AB                                                                                              \
+if (a->type == LX_INT && b->type == LX_INT) {                                                       \
+    unsigned long long result = (unsigned long long)a->integer op (unsigned long long)b->integer;   \
+    return lx_promote(ctx, (lx_Value) { .type = LX_INT, .integer = (long long)result });            \
+}                                                                                                   \
+if (lx_isnumber(a) && lx_isnumber(b)) {                                                             \
+    double result = lx_getnumber(a) op lx_getnumber(b);                                             \
+    return lx_promote(ctx, (lx_Value) { .type = LX_NUMBER, .number = result });                     \
 }
 
-#define COMP_OP(op)                                         \
-GET_AB                                                      \
-if (a->type != b->type) { return &lx_zero; }                \
-if (a->type == LX_NUMBER) {                                 \
-    return a->number ##op b->number ? &lx_one : &lx_zero;   \
-}
+#define COMP_OP(op)                                                         \
+GET_AB                                                                      \
+if (a->type == LX_INT && b->type == LX_INT) {                               \
+    return a->integer op b->integer ? &lx_one : &lx_zero;                   \
+}                                                                           \
+if (lx_isnumber(a) && lx_isnumber(b)) {                                     \
+    return lx_getnumber(a) op lx_getnumber(b) ? &lx_one : &lx_zero;         \
+}                                                                           \
+if (a->type != b->type) { return &lx_zero; }
+
+#define INT_OP(op) { start++; GET_AB return lx_intop(ctx, (op), a, b); }
 
 #define EAT_SPACE(str)                            \
     while (*(str) && lx_isspace(*(str))) (str)++; \
@@ -382,8 +1494,7 @@ if (a->type == LX_NUMBER) {                                 \
 
 #define PARSE_BODY(endchar, _call, afterparse)                              \
 EAT_SPACE(start);                                                           \
-if(*start == (endchar)) start++;                                            \
-else do {                                                                   \
+if(*start != (endchar)) do {                                                \
     lx_Value* value = lx_eval(ctx, (_call), start, &next, 1, side_effects); \
     result = value ? value : result;                                        \
     if (result->type == LX_EOF) return &lx_eof;                             \
@@ -393,16 +1504,18 @@ else do {                                                                   \
 } while (*start != (endchar)); start++
 
 #define PARSE_ARG                                                                                        \
-    EAT_SPACE(args);                                                                                     \
-    lx_marktemp(next_call.call.env);                                                                     \
+    while (*args && lx_isspace(*args)) args++;                                                           \
+    if (!*args) { ctx->frame_top = frame_top; return &lx_eof; }                                          \
+    lx_marktemp(ctx, next_call.call.env);                                                                \
     lx_Value arg_name = { .type = LX_SYMBOL, .symbol = { .start = args, .len = lx_word(args) } };        \
     args += arg_name.symbol.len;                                                                         \
-    BUBBLE_EOF(arg_value, lx_eval(ctx, call, start, &next, 1, side_effects))                             \
-    lx_setenv(ctx, next_call.call.env, lx_marktemp(lx_promote(ctx, arg_name)), lx_marktemp(arg_value));  \
+    lx_Value* arg_value = lx_eval(ctx, call, start, &next, 1, side_effects);                             \
+    if (arg_value->type == LX_EOF) { ctx->frame_top = frame_top; return &lx_eof; }                       \
+    lx_bindarg(ctx, next_call.call.env, arg_name, lx_marktemp(ctx, arg_value));                          \
     start = next                                                                                        
 
 
-lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** end, int eval_symbol, int side_effects) {
+static lx_Value* lx_evalexpr(lx_Ctx* ctx, lx_Value* call, const char* start, const char** end, int eval_symbol, int side_effects) {
     EAT_SPACE(start);
 
     WRITE_END;
@@ -422,16 +1535,24 @@ lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** e
     case '+': { ARITH_OP(+) return &lx_nil_; }
     case '-': { ARITH_OP(-) return &lx_nil_; }
     case '*': { ARITH_OP(*) return &lx_nil_; }
-    case '/': { ARITH_OP(/) return &lx_nil_; }
-    case '<': { if (*start == '=') { start++; COMP_OP(<=) } else { COMP_OP(<) } return &lx_nil_; }
-    case '>': { if (*start == '=') { start++; COMP_OP(>=) } else { COMP_OP(>) } return &lx_nil_; }
-    case '&': { GET_AB return lx_truthy(a) && lx_truthy(b) ? &lx_one : &lx_zero; }
-    case '|': { GET_AB return lx_truthy(a) || lx_truthy(b) ? &lx_one : &lx_zero; }
+    case '/': {
+        if (*start == '/') INT_OP('/')
+        GET_AB
+        if (lx_isnumber(a) && lx_isnumber(b)) { return lx_promote(ctx, (lx_Value) { .type = LX_NUMBER, .number = lx_getnumber(a) / lx_getnumber(b) }); }
+        return &lx_nil_;
+    }
+    case '<': { if (*start == '<') INT_OP('<') if (*start == '=') { start++; COMP_OP(<=) } else { COMP_OP(<) } return &lx_nil_; }
+    case '>': { if (*start == '>') INT_OP('>') if (*start == '=') { start++; COMP_OP(>=) } else { COMP_OP(>) } return &lx_nil_; }
+    case '&': { if (*start == '&') INT_OP('&') GET_AB return lx_truthy(a) && lx_truthy(b) ? &lx_one : &lx_zero; }
+    case '|': { if (*start == '|') INT_OP('|') GET_AB return lx_truthy(a) || lx_truthy(b) ? &lx_one : &lx_zero; }
     case '!': { BUBBLE_EOF(a, lx_eval(ctx, call, start, end, 1, side_effects)) return lx_truthy(a) ? &lx_zero : &lx_one; }
     case '_': {
             BUBBLE_EOF(a, lx_eval(ctx, call, start, end, 1, side_effects))
+            if (a->type == LX_INT) { return a; }
             if (a->type != LX_NUMBER) { return &lx_nil_; }
-            return lx_promote(ctx, (lx_Value) {.type = LX_NUMBER, .number = a->number > 0 ? (int)(a->number + 0.5) : (int)(a->number - 0.5) });
+            double n = a->number > 0 ? a->number + 0.5 : a->number - 0.5;
+            if (!(n > -9223372036854775808.0 && n < 9223372036854775808.0)) { return a; } // already whole if it's this large, nan and inf stay too
+            return lx_promote(ctx, (lx_Value) {.type = LX_INT, .integer = (long long)n });
     }
     case '(': { PARSE_BODY(')', call, 0); WRITE_END; return result; }
     case '{': {
@@ -442,42 +1563,67 @@ lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** e
         WRITE_END; return next_call.call.env ? next_call.call.env : &lx_nil_;
     }
     case '[': {
-        lx_Value* list_start = lx_list(ctx),* list_current = list_start;
+        lx_Value* list_start = lx_marktemp(ctx, lx_list(ctx)),* list_current = list_start;
         PARSE_BODY(']', call, list_current = lx_listappend(ctx, list_current, result));
         WRITE_END; return list_start;    
     }
     case '.': {
-        BUBBLE_EOF(env, lx_marktemp(lx_eval(ctx, call, start, &next, 1, side_effects)))
+        if (*start == '.') {
+            start++;
+            BUBBLE_EOF(from, lx_marktemp(ctx, lx_eval(ctx, call, start, &next, 1, side_effects)))
+            BUBBLE_EOF(to, lx_marktemp(ctx, lx_eval(ctx, call, next, &start, 1, side_effects)))
+            BUBBLE_EOF(step, lx_eval(ctx, call, start, end, 1, side_effects))
+            if (!lx_isnumber(from) || !lx_isnumber(to) || !lx_isnumber(step)) { return &lx_nil_; }
+            return lx_range(ctx, lx_getnumber(from), lx_getnumber(to), lx_getnumber(step));
+        }
+        BUBBLE_EOF(env, lx_marktemp(ctx, lx_eval(ctx, call, start, &next, 1, side_effects)))
         else if (env->type == LX_ENV) {
             BUBBLE_EOF(sym, lx_eval(ctx, call, next, end, 0, side_effects))
             return lx_getenv(lx_releasetemp(env), sym);
         }
         else if (lx_releasetemp(env)->type == LX_LIST) {
             BUBBLE_EOF(sym, lx_eval(ctx, call, next, end, 1, side_effects))
-            if (sym->type != LX_NUMBER) { return &lx_nil_; }
-            for (int i = 0; i < (int)sym->number; ++i) env = env->list.next ? env->list.next : 0;
+            if (!lx_isnumber(sym)) { return &lx_nil_; }
+            for (long long i = 0, n = lx_getint(sym); env && i < n; ++i) env = env->list.next;
             return env ? env->list.value : &lx_nil_;
+        }
+        else if (env->type == LX_RANGE) {
+            BUBBLE_EOF(sym, lx_eval(ctx, call, next, end, 1, side_effects))
+            if (!lx_isnumber(sym) || lx_getint(sym) < 0 || lx_getint(sym) >= lx_rangelen(env)) { return &lx_nil_; }
+            return lx_promote(ctx, lx_rangeat(env, (int)lx_getint(sym)));
+        }
+        else if (env->type == LX_BUFFER) {
+            BUBBLE_EOF(sym, lx_eval(ctx, call, next, end, 1, side_effects))
+            if (!lx_isnumber(sym) || lx_getint(sym) < 0 || lx_getint(sym) >= env->buffer.len) { return &lx_nil_; }
+            return lx_promote(ctx, lx_bufferget(env, (int)lx_getint(sym)));
         } else { BUBBLE_EOF(sym, lx_eval(ctx, call, next, end, 0, side_effects)) }
         return &lx_nil_;
     }
     case ':': {
-        BUBBLE_EOF(env, lx_marktemp(lx_eval(ctx, call, start, &next, 1, side_effects)))
+        BUBBLE_EOF(env, lx_marktemp(ctx, lx_eval(ctx, call, start, &next, 1, side_effects)))
 
         if (side_effects) {
             if (env->type == LX_ENV) {
-                BUBBLE_EOF(sym, lx_marktemp(lx_eval(ctx, call, next, &start, 0, side_effects)))
-                BUBBLE_EOF(val, lx_marktemp(lx_eval(ctx, call, start, end, 1, side_effects)))
+                BUBBLE_EOF(sym, lx_marktemp(ctx, lx_eval(ctx, call, next, &start, 0, side_effects)))
+                BUBBLE_EOF(val, lx_marktemp(ctx, lx_eval(ctx, call, start, end, 1, side_effects)))
                 lx_setenv(ctx, env, sym, val);
             }
             else if (env->type == LX_LIST) {
-                BUBBLE_EOF(sym, lx_marktemp(lx_eval(ctx, call, next, &start, 1, side_effects)))
-                BUBBLE_EOF(val, lx_marktemp(lx_eval(ctx, call, start, end, 1, side_effects)))
-                if (sym->type != LX_NUMBER) { return &lx_nil_; }
-                int n = (int)lx_releasetemp(sym)->number;
-                for (int i = 0; i < n; ++i) env = env->list.next ? env->list.next : 0;
-                if (lx_releasetemp(env)) { env->list.value = lx_releasetemp(val); }
-            } else { BUBBLE_EOF(sym, lx_marktemp(lx_eval(ctx, call, next, &start, 0, side_effects))) BUBBLE_EOF(val, lx_eval(ctx, call, start, end, 1, side_effects)) } 
-        } else { BUBBLE_EOF(sym, lx_marktemp(lx_eval(ctx, call, next, &start, 0, side_effects))) BUBBLE_EOF(val, lx_eval(ctx, call, start, end, 1, side_effects)) }
+                BUBBLE_EOF(sym, lx_marktemp(ctx, lx_eval(ctx, call, next, &start, 1, side_effects)))
+                BUBBLE_EOF(val, lx_marktemp(ctx, lx_eval(ctx, call, start, end, 1, side_effects)))
+                if (!lx_isnumber(sym)) { return &lx_nil_; }
+                long long n = lx_getint(lx_releasetemp(sym));
+                for (int i = 0; env && i < n; ++i) env = env->list.next;
+                if (lx_releasetemp(env)) { env->list.value = lx_stash(ctx, lx_releasetemp(val)); }
+            }
+            else if (env->type == LX_BUFFER) {
+                BUBBLE_EOF(sym, lx_marktemp(ctx, lx_eval(ctx, call, next, &start, 1, side_effects)))
+                BUBBLE_EOF(val, lx_eval(ctx, call, start, end, 1, side_effects))
+                if (!lx_isnumber(sym) || !lx_isnumber(val) || !env->buffer.writable) { return &lx_nil_; }
+                long long n = lx_getint(lx_releasetemp(sym));
+                if (n >= 0 && n < env->buffer.len) lx_bufferset(env, (int)n, lx_getnumber(val));
+            } else { BUBBLE_EOF(sym, lx_marktemp(ctx, lx_eval(ctx, call, next, &start, 0, side_effects))) BUBBLE_EOF(val, lx_eval(ctx, call, start, end, 1, side_effects)) } 
+        } else { BUBBLE_EOF(sym, lx_marktemp(ctx, lx_eval(ctx, call, next, &start, 0, side_effects))) BUBBLE_EOF(val, lx_eval(ctx, call, start, end, 1, side_effects)) }
         return &lx_nil_;
     }
     case '=': {
@@ -492,8 +1638,20 @@ lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** e
             if (a == b) return &lx_one;
             return &lx_nil_;
         }
-        BUBBLE_EOF(sym, lx_marktemp(lx_eval(ctx, call, start, &next, 0, side_effects)))
-        BUBBLE_EOF(val, lx_marktemp(lx_eval(ctx, call, next, end, 1, side_effects)))
+        // Plain names stay off the heap until the value is ready, a collection while evaluating it could free them otherwise
+        EAT_SPACE(start);
+        if (lx_isalpha(*start)) {
+            lx_Value name = { .type = LX_SYMBOL, .symbol = { .start = start, .len = lx_word(start) } };
+            BUBBLE_EOF(val, lx_marktemp(ctx, lx_eval(ctx, call, start + name.symbol.len, end, 1, side_effects)))
+            if (side_effects) {
+                if (!call->call.env) call->call.env = lx_makenv(ctx);
+                lx_bindarg(ctx, call->call.env, name, val);
+            }
+            return &lx_nil_;
+        }
+
+        BUBBLE_EOF(sym, lx_marktemp(ctx, lx_eval(ctx, call, start, &next, 0, side_effects)))
+        BUBBLE_EOF(val, lx_marktemp(ctx, lx_eval(ctx, call, next, end, 1, side_effects)))
 
         if (side_effects) {
             if (!call->call.env) call->call.env = lx_makenv(ctx);
@@ -511,42 +1669,66 @@ lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** e
         BUBBLE_EOF(sym, lx_eval(ctx, call, start, end, 0, side_effects))
         return lx_getcall(call, sym);
     case '?': {
-        BUBBLE_EOF(cond, lx_marktemp(lx_eval(ctx, call, start, &next, 1, side_effects)))
-        BUBBLE_EOF(true_result, lx_marktemp(lx_eval(ctx, call, next, &start, 1, side_effects && lx_truthy(cond))))
+        BUBBLE_EOF(cond, lx_marktemp(ctx, lx_eval(ctx, call, start, &next, 1, side_effects)))
+        BUBBLE_EOF(true_result, lx_marktemp(ctx, lx_eval(ctx, call, next, &start, 1, side_effects && lx_truthy(cond))))
         BUBBLE_EOF(false_result, lx_eval(ctx, call, start, end, 1, side_effects && !lx_truthy(cond)))
         return lx_truthy(lx_releasetemp(cond)) ? lx_releasetemp(true_result) : false_result;
     }
     case '#':
-        BUBBLE_EOF(list, lx_marktemp(lx_eval(ctx, call, start, &next, 1, side_effects)))
-        BUBBLE_EOF(item, lx_marktemp(lx_eval(ctx, call, next, end, 1, side_effects)))
+        BUBBLE_EOF(list, lx_marktemp(ctx, lx_eval(ctx, call, start, &next, 1, side_effects)))
+        BUBBLE_EOF(item, lx_marktemp(ctx, lx_eval(ctx, call, next, end, 1, side_effects)))
         return side_effects ? lx_listappend(ctx, lx_releasetemp(list), lx_releasetemp(item)) : &lx_nil_;
     case '\\': {
         BUBBLE_EOF(list, lx_eval(ctx, call, start, &next, 1, side_effects))
         WRITE_END; return side_effects ? lx_listpop(list) : &lx_nil_;
     }
     case '%': {
-        BUBBLE_EOF(list, lx_marktemp(lx_eval(ctx, call, start, &next, 1, side_effects)))
+        if (*start == '%') INT_OP('%')
+        BUBBLE_EOF(list, lx_marktemp(ctx, lx_eval(ctx, call, start, &next, 1, side_effects)))
         BUBBLE_EOF(name, (lx_eval(ctx, call, next, end, 0, side_effects)))
 
         const char* body_start = *end;
-        if (!list->list.value) lx_eval(ctx, call, body_start, end, 0, 0);
-        while (list && list->list.value) {
-            lx_setenv(ctx, call->call.env, lx_marktemp(name), lx_marktemp(list)->list.value);
+        if (!call->call.env) call->call.env = lx_makenv(ctx);
+        if (lx_isnumber(list) || list->type == LX_RANGE || list->type == LX_BUFFER) {
+            lx_Value range = !lx_isnumber(list) ? *list : (lx_Value) { .type = LX_RANGE, .range = { .start = 0, .end = lx_getnumber(list), .step = 1 } };
+            int len = !side_effects ? 0 : range.type == LX_BUFFER ? range.buffer.len : lx_rangelen(&range);
+            if (!len) { lx_eval(ctx, call, body_start, end, 0, 0); return result; }
+
+            lx_Value* counter = lx_marktemp(ctx, lx_promote(ctx, (lx_Value) { .type = LX_NUMBER, .transient = 1 }));
+            lx_marktemp(ctx, name);
+            for (int i = 0; i < len; i++) {
+                lx_Value at = range.type == LX_BUFFER ? lx_bufferget(&range, i) : lx_rangeat(&range, i);
+                counter->type = at.type;
+                counter->integer = at.integer; // copies doubles bit for bit too
+                lx_bindenv(ctx, call->call.env, name, counter);
+                result = lx_eval(ctx, call, body_start, end, 1, side_effects);
+            }
+            return result;
+        }
+        if (list->type != LX_LIST || !list->list.value) lx_eval(ctx, call, body_start, end, 0, 0);
+        lx_marktemp(ctx, name);
+        int temp_top = ctx->temp_top;
+        while (list && lx_islist(list) && list->list.value) {
+            ctx->temp_top = temp_top;
+            lx_setenv(ctx, call->call.env, name, lx_marktemp(ctx, list)->list.value);
             result = lx_eval(ctx, call, body_start, end, 1, side_effects);
             list = lx_listnext(list);
         }
         return result;
     }
     case '^':
+        if (*start == '^') INT_OP('^')
         const char* cond_start = start;
-        BUBBLE_EOF(cond, lx_marktemp(lx_eval(ctx, call, cond_start, &next, 1, side_effects)))
+        BUBBLE_EOF(cond, lx_marktemp(ctx, lx_eval(ctx, call, cond_start, &next, 1, side_effects)))
         const char* body_start = next;
         if (!lx_truthy(cond)) lx_eval(ctx, call, body_start, end, 0, 0);
+        int temp_top = ctx->temp_top;
         while (lx_truthy(cond)) {
+            ctx->temp_top = temp_top;
             lx_releasetemp(result);
-            result = lx_marktemp(lx_eval(ctx, call, body_start, end, 1, side_effects));
+            result = lx_marktemp(ctx, lx_eval(ctx, call, body_start, end, 1, side_effects));
             lx_releasetemp(cond);
-            cond = lx_marktemp(lx_eval(ctx, call, cond_start, &next, 1, side_effects));
+            cond = lx_marktemp(ctx, lx_eval(ctx, call, cond_start, &next, 1, side_effects));
             if (!side_effects) break;
         }
         return result;
@@ -556,11 +1738,14 @@ lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** e
         if (val->type == LX_STRING) { len = val->string.len; }
         else if (val->type == LX_ENV) { if (val->env.value) { len++; } while (val) { len++; val = val->env.next; } }
         else if (val->type == LX_LIST) { if (val->list.value) { len++; } while (val) { len++; val = val->list.next; } }
-        return len == -1 ? &lx_nil_ : lx_promote(ctx, (lx_Value) { .type = LX_NUMBER, .number = len });
+        else if (val->type == LX_RANGE) { len = lx_rangelen(val); }
+        else if (val->type == LX_BUFFER) { len = val->buffer.len; }
+        return len == -1 ? &lx_nil_ : lx_promote(ctx, (lx_Value) { .type = LX_INT, .integer = len });
     case '\'':
         result = lx_alloc(ctx, LX_FN, 1);
         EAT_SPACE(start);
         result->fn.arg_start = start;
+        result->fn.jit = 0;
         if (*start == '(') {
             while (*start && *start != ')') start++; start++;
             if (!*start) return &lx_eof;
@@ -574,7 +1759,7 @@ lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** e
         return result;
     default:
         start--;
-        if (lx_isdigit(*start)) return lx_promote(ctx, (lx_Value) { .type = LX_NUMBER, .number = lx_parsenumber(start, end) });
+        if (lx_isdigit(*start)) return lx_promote(ctx, lx_parseliteral(start, end));
         if (lx_isalpha(*start)) {
             lx_Value name = { .type = LX_SYMBOL, .symbol = { .start = start, .len = lx_word(start) } };
             start += name.symbol.len;
@@ -585,15 +1770,22 @@ lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** e
                 if (result->type == LX_FN || result->type == LX_CFN) {
                     const char* args = result->type == LX_FN ? result->fn.arg_start : result->cfn.args;
 
-                    lx_Value next_call = { .type = LX_CALL, .call = { .last = call, .env = lx_makenv(ctx), .callable = result } };
+                    lx_Value* frame_top = ctx->frame_top,* frame = lx_framepush(ctx);
+                    lx_Value next_call = { .type = LX_CALL, .call = { .last = call, .env = frame ? frame : lx_makenv(ctx), .callable = result } };
                     
                     if (*args == '(') { args++; while (*args && *args != ')') { PARSE_ARG; }
                     } else { PARSE_ARG; }
 
                     ctx->current = &next_call;
-                    if (side_effects && result->type == LX_FN) result = lx_eval(ctx, &next_call, result->fn.body_start, end, 1, side_effects);
+                    if (side_effects && result->type == LX_FN) {
+                        lx_Value* fn = result;
+                        result = lx_jitcall(ctx, fn, next_call.call.env);
+                        if (!result) result = lx_eval(ctx, &next_call, fn->fn.body_start, end, 1, side_effects);
+                    }
                     else if (side_effects) result = result->cfn.cfn(ctx, next_call.call.env); 
+                    if (lx_inframe(ctx, result)) result = lx_materialize(ctx, result);
                     ctx->current = ctx->current->call.last;
+                    ctx->frame_top = frame_top;
                     lx_releasetemp(next_call.call.env);
                 }
             }
@@ -605,6 +1797,13 @@ lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** e
     return &lx_eof;
 }
 
+lx_Value* lx_eval(lx_Ctx* ctx, lx_Value* call, const char* start, const char** end, int eval_symbol, int side_effects) {
+    int temp_top = ctx->temp_top;
+    lx_Value* result = lx_evalexpr(ctx, call, start, end, eval_symbol, side_effects);
+    ctx->temp_top = temp_top;
+    return result;
+}
+
 lx_Value* lx_run(lx_Ctx* ctx, lx_Value* env, const char* code) {
     int len = lx_strlen(code) + 1;
 
@@ -620,15 +1819,23 @@ lx_Value* lx_run(lx_Ctx* ctx, lx_Value* env, const char* code) {
     lx_Value call = {
         .type = LX_CALL, .call = { .last = ctx->current, .callable = 0, .env = env }
     };
-    lx_Value* result = &lx_nil_;
+    lx_Value* result = &lx_nil_,* frame_top = ctx->frame_top;
+    int temp_top = ctx->temp_top;
     ctx->current = &call;
     while (prog_current < prog_start + len) {
         lx_Value* value = lx_eval(ctx, &call, prog_current, &prog_next, 1, 1);
         if (value && value->type == LX_EOF) break;
         result = value ? value : result;
         prog_current = prog_next;
+        ctx->temp_top = temp_top;
+        lx_marktemp(ctx, result);
+
+        // Between top level expressions of the outermost run nothing but `result` and the call chain refer to cells
+        if (ctx->compact_every && !call.call.last && ctx->collections - ctx->compacted_at >= ctx->compact_every) lx_compactcells(ctx, &result);
     }
     ctx->current = call.call.last;
+    ctx->frame_top = frame_top;
+    ctx->temp_top = temp_top;
 
     return result;
 }
@@ -640,11 +1847,19 @@ lx_Value* lx_run(lx_Ctx* ctx, lx_Value* env, const char* code) {
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void lxcli_print(const char* msg) {
     printf("%s", msg);
 }
 
+void* lxcli_alloc(void* userdata, void* ptr, unsigned long long size) {
+    (void)userdata;
+    if (size) return malloc(size);
+    free(ptr);
+    return NULL;
+}
+
 char* lxcli_readfile(const char* path) {
     FILE* f = fopen(path, "rb");
     if (!f) return NULL;
@@ -662,7 +1877,7 @@ char* lxcli_readfile(const char* path) {
 }
 
 lx_Value* lxcli_cells(lx_Ctx* ctx, lx_Value* env) {
-    return lx_number(ctx, lx_cells(ctx));
+    return lx_int(ctx, lx_cells(ctx));
 }
 
 static char lxcli_loadbuf[1024];
@@ -690,10 +1905,19 @@ lx_Value* lxcli_load(lx_Ctx* ctx, lx_Value* env) {
 int main(int argc, char** argv) {
     char* lx_memory = malloc(LX_MEM_SIZE);
     lx_Ctx* ctx = lx_open(lx_memory, LX_MEM_SIZE / 2, LX_MEM_SIZE / 2, lxcli_print);
+    lx_setallocator(ctx, lxcli_alloc, NULL);
     lx_Value* env = lx_makenv(ctx); lx_persist(env);
     lx_setenvc(ctx, env, "cells", lx_cfn(ctx, "()", lxcli_cells));
     lx_setenvc(ctx, env, "load", lx_cfn(ctx, "path", lxcli_load));
 
+#ifdef LX_BUILD_JIT
+    int jit = argc > 1 && strcmp(argv[1], "-jit") == 0;
+    if (jit) {
+        if (!lx_jit(ctx, 1)) printf("Failed to enable the native tier, continuing without it\n");
+        argc--; argv++;
+    }
+#endif
+
     if (argc == 1) {
         printf("lx " LX_VERSION " (:q to quit)\n");
         printf("Cell count: %d\n", lx_cells(ctx));
@@ -712,6 +1936,10 @@ int main(int argc, char** argv) {
         lx_run(ctx, env, source);
         free(source);
     }
+
+#ifdef LX_BUILD_JIT
+    if (jit) fprintf(stderr, "%d functions compiled natively\n", lx_jitcount(ctx));
+#endif
     
     return 0;
 }
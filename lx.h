@@ -29,16 +29,65 @@ MIT License
 /* The size of the internal string format buffer, in characters */
 #define LX_FORMAT_LEN 64
 
+/* The maximum number of cells reserved for function call frames, taken from the end of cell memory */
+#ifndef LX_FRAME_CELLS
+#define LX_FRAME_CELLS 4096
+#endif
+
+/* The number of in-flight temporaries kept alive across collections, their stack is taken from the end of cell memory and moves to the allocator (if any) when it fills up */
+#ifndef LX_TEMP_SLOTS
+#define LX_TEMP_SLOTS 4096
+#endif
+
+/* With an allocator set, a collection that frees less than this percentage of cells adds a new segment of at least LX_SEGMENT_CELLS cells */
+#ifndef LX_GROW_PERCENT
+#define LX_GROW_PERCENT 25
+#endif
+
+#ifndef LX_SEGMENT_CELLS
+#define LX_SEGMENT_CELLS 4096
+#endif
+
+/* The number of handles a host can hold at once, see `lx_handle` */
+#ifndef LX_HANDLES
+#define LX_HANDLES 32
+#endif
+
+#ifdef LX_BUILD_JIT
+/* The number of calls a function takes before the native tier tries to compile it */
+#ifndef LX_JIT_THRESHOLD
+#define LX_JIT_THRESHOLD 32
+#endif
+#endif
+
 typedef void (*lx_Printer)(const char*);
 
+/* Host allocator - called with `ptr` NULL to allocate `size` bytes, and with `size` 0 to free `ptr` */
+typedef void* (*lx_Allocator)(void* userdata, void* ptr, unsigned long long size);
+
 typedef struct lx_Ctx lx_Ctx;
 typedef struct lx_Value lx_Value;
 
+/* Native function signature - `env` holds the arguments and lives on the call frame stack, it is only valid until the function returns (returning it directly is fine) */
 typedef lx_Value* (*lx_Cfn)(lx_Ctx* ctx, lx_Value* env);
 
 /* Creates a lx context inside the preallocated memory arena. prog_size is rom, cell_size is ram */
 lx_Ctx* lx_open(void* memory, unsigned long long prog_size, unsigned long long cell_size, lx_Printer printer);
 
+#ifdef LX_BUILD_JIT
+/* Enable or disable the x86-64 native tier, which compiles hot purely numeric functions to machine code. Returns whether the tier is now active */
+int lx_jit(lx_Ctx* ctx, int enable);
+
+/* Returns how many functions the native tier has compiled so far */
+int lx_jitcount(lx_Ctx* ctx);
+#endif
+
+/* Let the context grow beyond its arena by adding cell segments through `allocator`, and hand them back when compaction empties them. Without one, the arena is all there is */
+void lx_setallocator(lx_Ctx* ctx, lx_Allocator allocator, void* userdata);
+
+/* Release everything the context got from its allocator, the arena itself stays with the host */
+void lx_close(lx_Ctx* ctx);
+
 /* Returns the total number of cells available to the context */
 int lx_cells(lx_Ctx* ctx);
 
@@ -48,9 +97,22 @@ lx_Value* lx_run(lx_Ctx* ctx, lx_Value* env, const char* code);
 /* Run a garbage collection cycle on the context's cell memory, returning the number of cells freed */
 int lx_gc(lx_Ctx* ctx);
 
-/* Marks a value as persistent, stopping it from being garbage collected even with no live references */
+/* Marks a value as persistent, stopping it from being garbage collected even with no live references. Persistent values are also pinned, compaction never moves them */
 void lx_persist(lx_Value* val);
 
+/* Compact cell memory, moving every live value so lists and environments sit contiguously in the order they're walked. Returns the number of cells moved, or -1 if called while code is running.
+   Any `lx_Value*` the host holds on to that isn't persistent or behind a handle is invalid afterwards */
+int lx_compact(lx_Ctx* ctx);
+
+/* Let `lx_run` compact automatically between top level expressions once `every` collections have happened since the last compaction (0, the default, disables this) */
+void lx_setcompact(lx_Ctx* ctx, int every);
+
+/* Handles keep a value alive and follow it when compaction moves it - returns -1 if all LX_HANDLES are in use.
+   Getting a handle that's out of range or already released gives NULL, and releasing one does nothing */
+int lx_handle(lx_Ctx* ctx, lx_Value* val);
+lx_Value* lx_gethandle(lx_Ctx* ctx, int handle);
+void lx_releasehandle(lx_Ctx* ctx, int handle);
+
 /* Create a new environment */
 lx_Value* lx_makenv(lx_Ctx* ctx);
 
@@ -84,6 +146,11 @@ lx_Value* lx_number(lx_Ctx* ctx, double number);
 int lx_isnumber(lx_Value* val);
 double lx_getnumber(lx_Value* val);
 
+/* Make, check, and retrieve 64-bit integer values - lx_isnumber is true for integers too, and lx_getint truncates doubles */
+lx_Value* lx_int(lx_Ctx* ctx, long long integer);
+int lx_isint(lx_Value* val);
+long long lx_getint(lx_Value* val);
+
 /* Make, check, and retrieve string values - if a string is made outside of program code, the caller is responsible for the lifetime of the character data */
 lx_Value* lx_string(lx_Ctx* ctx, const char* str);
 int lx_isstring(lx_Value* val);
@@ -101,6 +168,17 @@ int lx_isfn(lx_Value* val);
 lx_Value* lx_cfn(lx_Ctx* ctx, const char* args, lx_Cfn cfn);
 int lx_iscfn(lx_Value* val);
 
+/* Make, check, and measure numeric ranges - a range covers `start` up to (but not including) `end` in increments of `step`, and measures at most INT_MAX steps */
+lx_Value* lx_range(lx_Ctx* ctx, double start, double end, double step);
+int lx_isrange(lx_Value* val);
+int lx_rangelen(lx_Value* val);
+
+/* Wrap `len` host-owned doubles or bytes as a buffer value, without copying - the data must outlive the value, and can only be stored into with `:` if `writable` is set */
+lx_Value* lx_buffer(lx_Ctx* ctx, double* data, int len, int writable);
+/* Stores into a byte buffer truncate towards zero and clamp to 0..255 (nan stores 0) */
+lx_Value* lx_bytes(lx_Ctx* ctx, unsigned char* data, int len, int writable);
+int lx_isbuffer(lx_Value* val);
+
 /* Make an empty list */
 lx_Value* lx_list(lx_Ctx* ctx);
 
@@ -113,8 +191,17 @@ lx_Value* lx_getlist(lx_Value* val);
 /* Return the next cell in the list, or NULL if at the end */
 lx_Value* lx_listnext(lx_Value* val);
 
-/* Append `item` to the end of `list` */
+/* Append `item` to the end of `list`, returning the new last cell - pass that back in as `list` to keep appending without walking the whole list */
 lx_Value* lx_listappend(lx_Ctx* ctx, lx_Value* list, lx_Value* item);
 
+/* Build a new list out of `count` values or numbers in one pass.
+   The values in `items` are kept alive while the list is built and by the list afterwards, so they can be fresh, otherwise unreferenced ones. The array itself is only read during the call */
+lx_Value* lx_listfromarray(lx_Ctx* ctx, lx_Value** items, int count);
+lx_Value* lx_listfromnumbers(lx_Ctx* ctx, const double* numbers, int count);
+
+/* Copy up to `max` items (or their number values) out of `list`, returning how many were written */
+int lx_listtoarray(lx_Value* list, lx_Value** items, int max);
+int lx_listtonumbers(lx_Value* list, double* numbers, int max);
+
 /* Remove the last item from `list` */
 lx_Value* lx_listpop(lx_Value* list);
\ No newline at end of file